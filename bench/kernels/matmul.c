@@ -0,0 +1,49 @@
+/*
+ * File:	matmul.c
+ *
+ * Description:	Multiply square matrices stored in row-major order, which
+ *		exercises nested loops and repeated address arithmetic.
+ */
+
+int a[10000], b[10000], c[10000];
+
+int multiply(int a[], int b[], int c[], int n)
+{
+    int i, j, k, s;
+
+    for (i = 0; i < n; i = i + 1)
+	for (j = 0; j < n; j = j + 1) {
+	    s = 0;
+
+	    for (k = 0; k < n; k = k + 1)
+		s = s + a[i * n + k] * b[k * n + j];
+
+	    c[i * n + j] = s;
+	}
+
+    return 0;
+}
+
+int main(void)
+{
+    int i, n, round, sum;
+
+    n = 100;
+    sum = 0;
+
+    for (i = 0; i < n * n; i = i + 1) {
+	a[i] = i % 17 - 8;
+	b[i] = i % 13 - 6;
+    }
+
+    for (round = 0; round < 40; round = round + 1) {
+	multiply(a, b, c, n);
+	a[round] = c[round * n + round] % 100;
+
+	for (i = 0; i < n * n; i = i + 1)
+	    sum = (sum + c[i]) % 1000000;
+    }
+
+    printf("%d\n", sum);
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * File:	sieve.c
+ *
+ * Description:	Count primes with the sieve of Eratosthenes, which
+ *		exercises tight loops over a large character array.
+ */
+
+char composite[1000000];
+
+int sieve(int n)
+{
+    int i, j, count;
+
+    for (i = 0; i < n; i = i + 1)
+	composite[i] = 0;
+
+    count = 0;
+
+    for (i = 2; i < n; i = i + 1)
+	if (!composite[i]) {
+	    count = count + 1;
+
+	    for (j = i + i; j < n; j = j + i)
+		composite[j] = 1;
+	}
+
+    return count;
+}
+
+int main(void)
+{
+    int round, sum;
+
+    sum = 0;
+
+    for (round = 0; round < 10; round = round + 1)
+	sum = sum + sieve(1000000 - round);
+
+    printf("%d\n", sum);
+    return 0;
+}
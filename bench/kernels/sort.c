@@ -0,0 +1,72 @@
+/*
+ * File:	sort.c
+ *
+ * Description:	Sort pseudo-random arrays with quicksort, which exercises
+ *		recursion, array indexing, and unpredictable branches.
+ */
+
+int a[20000];
+
+int partition(int a[], int lo, int hi)
+{
+    int pivot, i, j, t;
+
+    pivot = a[(lo + hi) / 2];
+    i = lo - 1;
+    j = hi + 1;
+
+    while (1) {
+	do i = i + 1; while (a[i] < pivot);
+	do j = j - 1; while (a[j] > pivot);
+
+	if (i >= j)
+	    return j;
+
+	t = a[i];
+	a[i] = a[j];
+	a[j] = t;
+    }
+
+    return j;
+}
+
+int quicksort(int a[], int lo, int hi)
+{
+    int p;
+
+    if (lo < hi) {
+	p = partition(a, lo, hi);
+	quicksort(a, lo, p);
+	quicksort(a, p + 1, hi);
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    int i, n, seed, round, sum;
+
+    n = 20000;
+    sum = 0;
+
+    for (round = 0; round < 20; round = round + 1) {
+	seed = round + 1;
+
+	for (i = 0; i < n; i = i + 1) {
+	    seed = (seed * 1103 + 12345) % 65536;
+	    a[i] = seed;
+	}
+
+	quicksort(a, 0, n - 1);
+
+	for (i = 1; i < n; i = i + 1)
+	    if (a[i - 1] > a[i])
+		sum = sum - 1000000;
+
+	sum = (sum + a[n / 2] + a[n / 3]) % 1000000;
+    }
+
+    printf("%d\n", sum);
+    return 0;
+}
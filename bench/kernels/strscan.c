@@ -0,0 +1,101 @@
+/*
+ * File:	strscan.c
+ *
+ * Description:	Scan a large string for words, vowels, and occurrences of
+ *		a pattern, which exercises character loads and compares.
+ */
+
+char text[200000];
+char pattern[8];
+
+int fill(char s[], int n)
+{
+    int i, seed;
+
+    seed = 7;
+
+    for (i = 0; i < n - 1; i = i + 1) {
+	seed = (seed * 1103 + 12345) % 65536;
+
+	if (seed % 7 == 0)
+	    s[i] = ' ';
+	else
+	    s[i] = 'a' + seed % 26;
+    }
+
+    s[n - 1] = 0;
+    return 0;
+}
+
+int words(char s[])
+{
+    int i, count, inword;
+
+    count = 0;
+    inword = 0;
+
+    for (i = 0; s[i] != 0; i = i + 1)
+	if (s[i] == ' ')
+	    inword = 0;
+	else if (!inword) {
+	    inword = 1;
+	    count = count + 1;
+	}
+
+    return count;
+}
+
+int vowels(char s[])
+{
+    int i, count;
+    char c;
+
+    count = 0;
+
+    for (i = 0; s[i] != 0; i = i + 1) {
+	c = s[i];
+
+	if (c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u')
+	    count = count + 1;
+    }
+
+    return count;
+}
+
+int find(char s[], char p[])
+{
+    int i, j, count;
+
+    count = 0;
+
+    for (i = 0; s[i] != 0; i = i + 1) {
+	j = 0;
+
+	while (p[j] != 0 && s[i + j] == p[j])
+	    j = j + 1;
+
+	if (p[j] == 0)
+	    count = count + 1;
+    }
+
+    return count;
+}
+
+int main(void)
+{
+    int round, sum;
+
+    fill(text, 200000);
+    pattern[0] = 'a';
+    pattern[1] = 'b';
+    pattern[2] = 0;
+    sum = 0;
+
+    for (round = 0; round < 20; round = round + 1) {
+	pattern[0] = 'a' + round;
+	sum = sum + words(text) + vowels(text) + find(text, pattern);
+    }
+
+    printf("%d\n", sum);
+    return 0;
+}
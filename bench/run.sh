@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+# File:		run.sh
+#
+# Description:	Measure the throughput of the compiler on each kind of
+#		synthetic program at a few sizes.  For each program, the
+#		time spent in each phase is taken from the statistics that
+#		the compiler writes with --stats, and is reported along
+#		with the lines compiled per second and the peak memory use.
+#		Any arguments are passed on to the compiler, so the same
+#		programs can be compiled with different optimizations.
+#
+#		The compiler to use is given by TCC, and all sizes are
+#		multiplied by SCALE.
+#
+
+TCC=${TCC:-../src/tcc}
+SCALE=${SCALE:-1}
+SYNTH=./synth
+TMP=${TMPDIR:-/tmp}/bench.$$
+
+trap 'rm -f $TMP.c $TMP.s $TMP.err' 0
+
+printf "%-10s %6s %7s %8s %8s %8s %8s %8s %9s %9s %8s\n" kind size lines \
+    lex parse trans opt gen "total ms" "lines/s" "RSS KB"
+
+for test in functions:100 functions:1000 nesting:50 nesting:200 \
+	straight:1000 straight:5000 chain:200 chain:1000 arrays:100 \
+	arrays:1000; do
+    kind=${test%:*}
+    size=$((${test#*:} * SCALE))
+
+    $SYNTH $kind $size > $TMP.c || exit 1
+    lines=$(wc -l < $TMP.c)
+
+    if ! $TCC -S --stats "$@" $TMP.c > $TMP.s 2> $TMP.err; then
+	echo "$kind $size: compilation failed" >&2
+	cat $TMP.err >&2
+	exit 1
+    fi
+
+    awk -v kind=$kind -v size=$size -v lines=$lines '
+	$1 == "lexing" { lex = $2 }
+	$1 == "parsing" { parse = $2 }
+	$1 == "translation" { trans = $2 }
+	$1 == "optimization" { opt = $2 }
+	$1 == "generation" { gen = $2 }
+	$1 == "peak" { rss = $3 }
+	END {
+	    total = lex + parse + trans + opt + gen
+	    rate = total > 0 ? lines / (total / 1000) : 0
+	    printf "%-10s %6d %7d %8.2f %8.2f %8.2f %8.2f %8.2f %9.2f %9.0f %8d\n",
+		kind, size, lines, lex, parse, trans, opt, gen, total, rate, rss
+	}' $TMP.err
+done
@@ -0,0 +1,91 @@
+#!/bin/sh
+#
+# File:		runtime.sh
+#
+# Description:	Measure how fast the generated code runs under each set of
+#		optimization flags.  Each kernel is compiled with each set
+#		of flags, then assembled and linked with the system C
+#		compiler, and run.  We report the size of the code in the
+#		kernel's object file, the cycles and instructions counted
+#		by perf when it is available, and the best elapsed time
+#		over several runs.  The output of each run is checked
+#		against the output of the kernel compiled with the first
+#		set of flags, which is no flags at all by default.  The
+#		kernels to run may be given as arguments.
+#
+#		The compiler to use is given by TCC, the C compiler used to
+#		assemble and link by CC, the target by TARGET, and the
+#		number of runs by RUNS.  The sets of flags are given by
+#		FLAGS, with the flags within a set separated by commas.
+#
+
+TCC=${TCC:-../src/tcc}
+CC=${CC:-cc}
+TARGET=${TARGET:--m64}
+RUNS=${RUNS:-3}
+FLAGS=${FLAGS:-"none --dce --cprop --lvn --asimp --cfold
+    --dce,--cprop,--lvn,--asimp,--cfold"}
+TMP=${TMPDIR:-/tmp}/runtime.$$
+
+trap 'rm -f $TMP $TMP.s $TMP.o $TMP.out $TMP.ref $TMP.perf' 0
+
+if command -v perf > /dev/null 2>&1 &&
+	perf stat -x, -e cycles true > /dev/null 2>&1; then
+    PERF="perf stat -x, -e cycles,instructions -o $TMP.perf"
+else
+    PERF=
+fi
+
+printf "%-10s %-36s %8s %14s %14s %9s\n" kernel flags text cycles \
+    instructions ms
+
+if [ $# -eq 0 ]; then
+    set -- kernels/*.c
+fi
+
+for kernel in "$@"; do
+    name=$(basename $kernel .c)
+    rm -f $TMP.ref
+
+    for set in $FLAGS; do
+	flags=$(echo $set | sed -e 's/^none$//' -e 's/,/ /g')
+
+	if ! $TCC -S $TARGET $flags $kernel > $TMP.s ||
+		! $CC $TARGET -c -o $TMP.o $TMP.s ||
+		! $CC $TARGET -o $TMP $TMP.o; then
+	    echo "$name $set: build failed" >&2
+	    continue
+	fi
+
+	text=$(size $TMP.o | awk 'NR == 2 { print $1 }')
+	cycles=-
+	insns=-
+	best=
+
+	for run in $(seq $RUNS); do
+	    start=$(date +%s%N)
+	    $PERF $TMP > $TMP.out
+	    stop=$(date +%s%N)
+	    ms=$(((stop - start) / 1000000))
+
+	    if [ -z "$best" ] || [ $ms -lt $best ]; then
+		best=$ms
+
+		if [ -n "$PERF" ]; then
+		    cycles=$(awk -F, '$3 ~ /^cycles/ { print $1 }' $TMP.perf)
+		    insns=$(awk -F, '$3 ~ /^instructions/ { print $1 }' \
+			$TMP.perf)
+		fi
+	    fi
+	done
+
+	if [ ! -f $TMP.ref ]; then
+	    cp $TMP.out $TMP.ref
+	elif ! cmp -s $TMP.out $TMP.ref; then
+	    best="$best WRONG"
+	fi
+
+	printf "%-10s %-36s %8s %14s %14s %9s\n" $name "$set" $text \
+	    $cycles $insns "$best"
+    done
+done
@@ -0,0 +1,233 @@
+/*
+ * File:	synth.cpp
+ *
+ * Description:	This file contains a generator of synthetic Tiny C
+ *		programs for measuring the throughput of the compiler.
+ *		Each kind of program stresses a different part of the
+ *		compiler, and is scaled by the given size:
+ *
+ *		functions	many small functions
+ *		nesting		deeply nested loops and conditionals
+ *		straight	one long block of straight-line code
+ *		chain		a long chain of if-else statements
+ *		arrays		many large global arrays
+ *
+ *		The program is written to the standard output with one
+ *		statement per line, so that the number of lines reflects
+ *		the amount of work.
+ */
+
+# include <string>
+# include <cstdlib>
+# include <iostream>
+
+using namespace std;
+
+
+/*
+ * Function:	functions
+ *
+ * Description:	Generate the given number of small functions, each with
+ *		a loop and a conditional, and a main function that calls
+ *		them all.
+ */
+
+static void functions(unsigned size)
+{
+    cout << "int g;" << endl;
+
+    for (unsigned i = 0; i < size; i ++) {
+	cout << "int f" << i << "(int a, int b)" << endl;
+	cout << "{" << endl;
+	cout << "    int i, s;" << endl;
+	cout << "    s = 0;" << endl;
+	cout << "    for (i = 0; i < a; i = i + 1) {" << endl;
+	cout << "\ts = s + i * b + g;" << endl;
+	cout << "\tif (s > " << 100 + i << ")" << endl;
+	cout << "\t    s = s - a;" << endl;
+	cout << "    }" << endl;
+	cout << "    return s + " << i << ";" << endl;
+	cout << "}" << endl;
+    }
+
+    cout << "int main(void)" << endl;
+    cout << "{" << endl;
+    cout << "    int t;" << endl;
+    cout << "    t = 0;" << endl;
+
+    for (unsigned i = 0; i < size; i ++)
+	cout << "    t = t + f" << i << "(t, " << i << ");" << endl;
+
+    cout << "    return t;" << endl;
+    cout << "}" << endl;
+}
+
+
+/*
+ * Function:	nesting
+ *
+ * Description:	Generate a function whose body alternates loops and
+ *		conditionals to the given depth.
+ */
+
+static void nesting(unsigned size)
+{
+    string indent;
+
+
+    cout << "int main(void)" << endl;
+    cout << "{" << endl;
+    cout << "    int i, s;" << endl;
+    cout << "    i = 0;" << endl;
+    cout << "    s = 0;" << endl;
+
+    for (unsigned i = 0; i < size; i ++) {
+	indent += " ";
+
+	if (i % 2 == 0)
+	    cout << indent << "while (i < " << i + 10 << ") {" << endl;
+	else
+	    cout << indent << "if (s != " << i << ") {" << endl;
+
+	cout << indent << "s = s + i;" << endl;
+	cout << indent << "i = i + 1;" << endl;
+    }
+
+    for (unsigned i = 0; i < size; i ++) {
+	cout << indent << "}" << endl;
+	indent.pop_back();
+    }
+
+    cout << "    return s;" << endl;
+    cout << "}" << endl;
+}
+
+
+/*
+ * Function:	straight
+ *
+ * Description:	Generate a function with the given number of assignments
+ *		in a single basic block, reusing a few variables and
+ *		expressions so that there is something to optimize.
+ */
+
+static void straight(unsigned size)
+{
+    cout << "int main(void)" << endl;
+    cout << "{" << endl;
+    cout << "    int a, b, c, d, e;" << endl;
+    cout << "    a = 1;" << endl;
+    cout << "    b = 2;" << endl;
+    cout << "    c = 3;" << endl;
+    cout << "    d = 4;" << endl;
+    cout << "    e = 5;" << endl;
+
+    for (unsigned i = 0; i < size; i ++)
+	switch (i % 5) {
+	case 0: cout << "    a = b + c * " << i << ";" << endl; break;
+	case 1: cout << "    b = a - d;" << endl; break;
+	case 2: cout << "    c = a * b + c * d;" << endl; break;
+	case 3: cout << "    d = e + 0 * a;" << endl; break;
+	case 4: cout << "    e = b + c * " << i - 4 << ";" << endl; break;
+	}
+
+    cout << "    return a + b + c + d + e;" << endl;
+    cout << "}" << endl;
+}
+
+
+/*
+ * Function:	chain
+ *
+ * Description:	Generate a function that selects among the given number
+ *		of cases with a chain of if-else statements, as a switch
+ *		statement would be written in Tiny C.
+ */
+
+static void chain(unsigned size)
+{
+    cout << "int select(int x)" << endl;
+    cout << "{" << endl;
+    cout << "    int r;" << endl;
+    cout << "    r = 0;" << endl;
+
+    for (unsigned i = 0; i < size; i ++) {
+	cout << "    " << (i > 0 ? "else " : "");
+	cout << "if (x == " << i << ")" << endl;
+	cout << "\tr = x * " << i % 7 + 1 << " + " << i << ";" << endl;
+    }
+
+    cout << "    else" << endl;
+    cout << "\tr = -1;" << endl;
+    cout << "    return r;" << endl;
+    cout << "}" << endl;
+}
+
+
+/*
+ * Function:	arrays
+ *
+ * Description:	Generate the given number of large global arrays and a
+ *		function that fills and sums each of them.
+ */
+
+static void arrays(unsigned size)
+{
+    for (unsigned i = 0; i < size; i ++)
+	cout << "int a" << i << "[" << 1000 + i << "];" << endl;
+
+    cout << "int main(void)" << endl;
+    cout << "{" << endl;
+    cout << "    int i, s;" << endl;
+    cout << "    s = 0;" << endl;
+
+    for (unsigned i = 0; i < size; i ++) {
+	cout << "    for (i = 0; i < " << 1000 + i << "; i = i + 1)" << endl;
+	cout << "\ta" << i << "[i] = i * " << i << ";" << endl;
+	cout << "    for (i = 0; i < " << 1000 + i << "; i = i + 1)" << endl;
+	cout << "\ts = s + a" << i << "[i];" << endl;
+    }
+
+    cout << "    return s;" << endl;
+    cout << "}" << endl;
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Generate the program of the kind and size given on the
+ *		command line.
+ */
+
+int main(int argc, char *argv[])
+{
+    string kind;
+    int size;
+
+
+    if (argc != 3 || (size = atoi(argv[2])) <= 0) {
+	cerr << "usage: synth functions|nesting|straight|chain|arrays size";
+	cerr << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    kind = argv[1];
+
+    if (kind == "functions")
+	functions(size);
+    else if (kind == "nesting")
+	nesting(size);
+    else if (kind == "straight")
+	straight(size);
+    else if (kind == "chain")
+	chain(size);
+    else if (kind == "arrays")
+	arrays(size);
+    else {
+	cerr << "synth: unknown kind '" << kind << "'" << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,147 @@
+/*
+ * File:	Arena.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		arenas.  Memory is carved out of large chunks, and an
+ *		allocation larger than a chunk gets a chunk of its own.
+ */
+
+# include <cassert>
+# include "Arena.h"
+
+using namespace std;
+
+static const size_t chunk_size = 64 * 1024;
+static const size_t alignment = alignof(max_align_t);
+
+thread_local Arena *Arena::_current = nullptr;
+
+
+/*
+ * Function:	Arena::Arena (constructor)
+ *
+ * Description:	Initialize an empty arena.  No memory is allocated until
+ *		it is needed.
+ */
+
+Arena::Arena()
+    : _next(nullptr), _limit(nullptr)
+{
+}
+
+
+/*
+ * Function:	Arena::~Arena (destructor)
+ *
+ * Description:	Release all memory held by this arena.
+ */
+
+Arena::~Arena()
+{
+    release();
+
+    if (_current == this)
+	_current = nullptr;
+}
+
+
+/*
+ * Function:	Arena::allocate
+ *
+ * Description:	Allocate a suitably aligned block of memory of the given
+ *		size from this arena.
+ */
+
+void *Arena::allocate(size_t size)
+{
+    char *ptr;
+
+
+    size = (size + alignment - 1) & ~(alignment - 1);
+
+    if (size > chunk_size) {
+	ptr = new char[size];
+	_chunks.push_back(ptr);
+	return ptr;
+    }
+
+    if (_next == nullptr || size > (size_t) (_limit - _next)) {
+	_next = new char[chunk_size];
+	_limit = _next + chunk_size;
+	_chunks.push_back(_next);
+    }
+
+    ptr = _next;
+    _next += size;
+    return ptr;
+}
+
+
+/*
+ * Function:	Arena::release
+ *
+ * Description:	Release all memory allocated from this arena.  Any objects
+ *		allocated from it must no longer be used.
+ */
+
+void Arena::release()
+{
+    for (auto chunk : _chunks)
+	delete[] chunk;
+
+    _chunks.clear();
+    _next = _limit = nullptr;
+}
+
+
+/*
+ * Function:	Arena::current (accessor)
+ *
+ * Description:	Return the arena from which statements and blocks are
+ *		currently being allocated on this thread.
+ */
+
+Arena *Arena::current()
+{
+    return _current;
+}
+
+
+/*
+ * Function:	Arena::current (mutator)
+ *
+ * Description:	Update the arena from which statements and blocks are
+ *		allocated on this thread.
+ */
+
+void Arena::current(Arena *arena)
+{
+    _current = arena;
+}
+
+
+/*
+ * Function:	operator new
+ *
+ * Description:	Allocate an object from the given arena, as in:
+ *
+ *		  new (arena) Symbol(name, type, kind)
+ */
+
+void *operator new(size_t size, Arena &arena)
+{
+    return arena.allocate(size);
+}
+
+
+/*
+ * Function:	operator delete
+ *
+ * Description:	Matching deallocation function for the placement form of
+ *		operator new above, called only if a constructor throws.
+ *		The memory is reclaimed when the arena is released.
+ */
+
+void operator delete(void *ptr, Arena &arena)
+{
+}
@@ -0,0 +1,47 @@
+/*
+ * File:	Arena.h
+ *
+ * Description:	This file contains the class definition for arenas, which
+ *		are simple bump allocators.  All the intermediate
+ *		representation of a function (its statements, basic
+ *		blocks, and temporaries) is allocated from a single arena,
+ *		so that it can be released all at once when we are done
+ *		with the function rather than one object at a time.
+ *
+ *		Statements and blocks are allocated from the current arena
+ *		by their class-specific operator new.  Deleting one runs
+ *		its destructor, but its memory is only reclaimed when the
+ *		arena is released.  The current arena is per thread.
+ */
+
+# ifndef ARENA_H
+# define ARENA_H
+# include <vector>
+# include <cstddef>
+
+class Arena {
+    typedef std::size_t size_t;
+
+    std::vector<char *> _chunks;
+    char *_next, *_limit;
+
+    static thread_local Arena *_current;
+
+public:
+    Arena();
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator =(const Arena &) = delete;
+
+    void *allocate(size_t size);
+    void release();
+
+    static Arena *current();
+    static void current(Arena *arena);
+};
+
+void *operator new(std::size_t size, Arena &arena);
+void operator delete(void *ptr, Arena &arena);
+
+# endif /* ARENA_H */
@@ -0,0 +1,298 @@
+/*
+ * File:	BitVector.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		dense bit vectors.
+ *
+ *		Any bits in the last word beyond the size of the vector
+ *		are always kept clear, so that comparison and counting can
+ *		simply operate on whole words.  The set operations are
+ *		written as plain loops over the words so that the compiler
+ *		is free to vectorize them.
+ *
+ *		To iterate over the elements of a set:
+ *
+ *		  for (unsigned i = s.first(); i < s.size(); i = s.next(i))
+ */
+
+# include <cassert>
+# include "BitVector.h"
+
+using namespace std;
+
+
+/*
+ * Function:	BitVector::BitVector (constructor)
+ *
+ * Description:	Initialize this bit vector with the given number of bits,
+ *		all of which are either set or clear.
+ */
+
+BitVector::BitVector(unsigned size, bool value)
+    : _words((size + bits - 1) / bits, value ? ~word(0) : 0), _size(size)
+{
+    trim();
+}
+
+
+/*
+ * Function:	BitVector::trim (private)
+ *
+ * Description:	Clear any bits in the last word beyond the end of the
+ *		vector.
+ */
+
+void BitVector::trim()
+{
+    if (_size % bits != 0)
+	_words.back() &= (word(1) << (_size % bits)) - 1;
+}
+
+
+/*
+ * Function:	BitVector::resize
+ *
+ * Description:	Change the number of bits in this vector.  Any new bits
+ *		are either set or clear as requested.
+ */
+
+void BitVector::resize(unsigned size, bool value)
+{
+    unsigned old = _size;
+
+    _words.resize((size + bits - 1) / bits, value ? ~word(0) : 0);
+    _size = size;
+
+    if (value && old < size && old % bits != 0)
+	_words[old / bits] |= ~word(0) << (old % bits);
+
+    trim();
+}
+
+
+/*
+ * Function:	BitVector::test
+ *
+ * Description:	Return whether the given bit is set.
+ */
+
+bool BitVector::test(unsigned i) const
+{
+    assert(i < _size);
+    return (_words[i / bits] >> (i % bits)) & 1;
+}
+
+
+/*
+ * Function:	BitVector::set
+ *
+ * Description:	Set the given bit.
+ */
+
+void BitVector::set(unsigned i)
+{
+    assert(i < _size);
+    _words[i / bits] |= word(1) << (i % bits);
+}
+
+
+/*
+ * Function:	BitVector::reset
+ *
+ * Description:	Clear the given bit.
+ */
+
+void BitVector::reset(unsigned i)
+{
+    assert(i < _size);
+    _words[i / bits] &= ~(word(1) << (i % bits));
+}
+
+
+/*
+ * Function:	BitVector::clear
+ *
+ * Description:	Clear all bits, making this vector the empty set.
+ */
+
+void BitVector::clear()
+{
+    for (unsigned i = 0; i < _words.size(); i ++)
+	_words[i] = 0;
+}
+
+
+/*
+ * Function:	BitVector::fill
+ *
+ * Description:	Set all bits, making this vector the universal set.
+ */
+
+void BitVector::fill()
+{
+    for (unsigned i = 0; i < _words.size(); i ++)
+	_words[i] = ~word(0);
+
+    trim();
+}
+
+
+/*
+ * Function:	BitVector::empty (predicate)
+ *
+ * Description:	Return whether no bits are set.
+ */
+
+bool BitVector::empty() const
+{
+    for (unsigned i = 0; i < _words.size(); i ++)
+	if (_words[i] != 0)
+	    return false;
+
+    return true;
+}
+
+
+/*
+ * Function:	BitVector::count
+ *
+ * Description:	Return the number of bits that are set.
+ */
+
+unsigned BitVector::count() const
+{
+    unsigned n = 0;
+
+    for (unsigned i = 0; i < _words.size(); i ++)
+	n += __builtin_popcountll(_words[i]);
+
+    return n;
+}
+
+
+/*
+ * Function:	BitVector::first
+ *
+ * Description:	Return the index of the first set bit, or the size of the
+ *		vector if no bit is set.
+ */
+
+unsigned BitVector::first() const
+{
+    for (unsigned i = 0; i < _words.size(); i ++)
+	if (_words[i] != 0)
+	    return i * bits + __builtin_ctzll(_words[i]);
+
+    return _size;
+}
+
+
+/*
+ * Function:	BitVector::next
+ *
+ * Description:	Return the index of the first set bit after the given
+ *		bit, or the size of the vector if there is none.
+ */
+
+unsigned BitVector::next(unsigned i) const
+{
+    unsigned w;
+    word rest;
+
+
+    if (++ i >= _size)
+	return _size;
+
+    w = i / bits;
+    rest = _words[w] & (~word(0) << (i % bits));
+
+    while (rest == 0) {
+	if (++ w == _words.size())
+	    return _size;
+
+	rest = _words[w];
+    }
+
+    return w * bits + __builtin_ctzll(rest);
+}
+
+
+/*
+ * Function:	BitVector::operator |=
+ *
+ * Description:	Destructive set union: this = this + that.
+ */
+
+BitVector &BitVector::operator |=(const BitVector &that)
+{
+    assert(_size == that._size);
+
+    for (unsigned i = 0; i < _words.size(); i ++)
+	_words[i] |= that._words[i];
+
+    return *this;
+}
+
+
+/*
+ * Function:	BitVector::operator &=
+ *
+ * Description:	Destructive set intersection: this = this * that.
+ */
+
+BitVector &BitVector::operator &=(const BitVector &that)
+{
+    assert(_size == that._size);
+
+    for (unsigned i = 0; i < _words.size(); i ++)
+	_words[i] &= that._words[i];
+
+    return *this;
+}
+
+
+/*
+ * Function:	BitVector::operator -=
+ *
+ * Description:	Destructive set difference: this = this - that.
+ */
+
+BitVector &BitVector::operator -=(const BitVector &that)
+{
+    assert(_size == that._size);
+
+    for (unsigned i = 0; i < _words.size(); i ++)
+	_words[i] &= ~that._words[i];
+
+    return *this;
+}
+
+
+/*
+ * Function:	BitVector::operator ==
+ *
+ * Description:	Return whether two bit vectors contain the same elements.
+ */
+
+bool BitVector::operator ==(const BitVector &that) const
+{
+    return _size == that._size && _words == that._words;
+}
+
+
+/*
+ * Function:	operator <<
+ *
+ * Description:	Write a bit vector to the specified stream as the set of
+ *		indices of its set bits.
+ */
+
+ostream &operator <<(ostream &ostr, const BitVector &bv)
+{
+    ostr << "{";
+
+    for (unsigned i = bv.first(); i < bv.size(); i = bv.next(i))
+	ostr << (i != bv.first() ? "," : "") << i;
+
+    return ostr << "}";
+}
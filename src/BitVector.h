@@ -0,0 +1,54 @@
+/*
+ * File:	BitVector.h
+ *
+ * Description:	This file contains the class definition for dense bit
+ *		vectors, which are used to represent the sets computed by
+ *		the dataflow analyses.  Each element of a set is identified
+ *		by its index in a universe, so set union, difference, and
+ *		intersection operate on an entire word of elements at a
+ *		time rather than on one element at a time.
+ */
+
+# ifndef BITVECTOR_H
+# define BITVECTOR_H
+# include <vector>
+# include <ostream>
+
+class BitVector {
+    typedef unsigned long long word;
+    static const unsigned bits = 8 * sizeof(word);
+
+    std::vector<word> _words;
+    unsigned _size;
+
+    void trim();
+
+public:
+    BitVector(unsigned size = 0, bool value = false);
+
+    unsigned size() const { return _size; }
+    void resize(unsigned size, bool value = false);
+
+    bool test(unsigned i) const;
+    void set(unsigned i);
+    void reset(unsigned i);
+
+    void clear();
+    void fill();
+    bool empty() const;
+    unsigned count() const;
+
+    unsigned first() const;
+    unsigned next(unsigned i) const;
+
+    BitVector &operator |=(const BitVector &that);
+    BitVector &operator &=(const BitVector &that);
+    BitVector &operator -=(const BitVector &that);
+
+    bool operator ==(const BitVector &that) const;
+    bool operator !=(const BitVector &that) const { return !(*this == that); }
+};
+
+std::ostream &operator <<(std::ostream &ostr, const BitVector &bv);
+
+# endif /* BITVECTOR_H */
@@ -28,11 +28,26 @@
  */
 
 # include "Block.h"
+# include "Arena.h"
+# include <cassert>
 # include <algorithm>
 
 using namespace std;
 
 
+/*
+ * Function:	Block::operator new
+ *
+ * Description:	Allocate a block from the current arena.
+ */
+
+void *Block::operator new(size_t size)
+{
+    assert(Arena::current() != nullptr);
+    return Arena::current()->allocate(size);
+}
+
+
 /*
  * Function:	Block::Block (constructor)
  *
@@ -40,12 +55,8 @@ using namespace std;
  */
 
 Block::Block()
-    : _next(nullptr)
-{/*
-	_UEVar = unordered_set<Symbol *>();
-	_VarKill = unordered_set<Symbol *>();
-	_LiveOut = unordered_set<Symbol *>();
-*/
+    : _next(nullptr), _idom(nullptr)
+{
 }
 
 
@@ -71,8 +82,9 @@ void Block::link(Block *successor)
 void Block::unlink(Block *successor)
 {
     Blocks &preds = successor->_predecessors;
-    _successors.erase(remove(_successors.begin(), _successors.end(), successor));
-    preds.erase(remove(preds.begin(), preds.end(), this));
+    _successors.erase(remove(_successors.begin(), _successors.end(), successor),
+	_successors.end());
+    preds.erase(remove(preds.begin(), preds.end(), this), preds.end());
 }
 
 
@@ -6,13 +6,20 @@
  *		successors in the control-flow graph, as well as iterators
  *		to its first and last statements.  Each block also has a
  *		link to the next block sequentially, for easily traversing
- *		all the blocks in a sequence.
+ *		all the blocks in a sequence.  Once the dominators have
+ *		been computed, each block also has a link to its immediate
+ *		dominator and the blocks it immediately dominates, and
+ *		once the dominance frontiers have been computed, the blocks
+ *		in its frontier.
  *
  *		For iterating through the block, forward and reverse
  *		iterators are supported.  These iterators traverse the
  *		non-label statements in the block, which allows us to
  *		process the actual statements without worrying about the
  *		labels.
+ *
+ *		Like statements, blocks are allocated from the arena of
+ *		their function.
  */
 
 # ifndef BLOCK_H
@@ -20,7 +27,7 @@
 # include <vector>
 # include <ostream>
 # include "Statement.h"
-# include <unordered_set>
+# include "dataflow.h"
 
 typedef std::vector<Block *> Blocks;
 
@@ -28,13 +35,19 @@ struct Block {
     Block *_next;
     Blocks _predecessors, _successors;
     Statements::iterator _first, _last;
+    Block *_idom;
+    Blocks _dominated;
+    Blocks _frontier;
 
-	std::unordered_set<Symbol *> _UEVar;
-	std::unordered_set<Symbol *> _VarKill;
-	std::unordered_set<Symbol *> _LiveOut;
+	sym_set _UEVar;
+	sym_set _VarKill;
+	sym_set _LiveOut;
 	expr_set ExprKill;
 	expr_set DEExprs;
 	expr_set AvailIn;
+    static void *operator new(std::size_t size);
+    static void operator delete(void *ptr) {}
+
     Block();
     void link(Block *successor);
     void unlink(Block *successor);
@@ -43,6 +56,10 @@ struct Block {
     const Blocks &predecessors() const { return _predecessors; }
     const Blocks &successors() const { return _successors; }
 
+    Block *idom() const { return _idom; }
+    const Blocks &dominated() const { return _dominated; }
+    const Blocks &frontier() const { return _frontier; }
+
     Statements::iterator first() const { return _first; }
     Statements::iterator last() const { return _last; }
 
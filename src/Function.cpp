@@ -19,6 +19,38 @@ std::unordered_map<Symbol *, Function> functions;
 
 Function::Function()
     : body(nullptr), exit(nullptr), entry(nullptr),
-      locals(nullptr), symbol(nullptr)
+      locals(nullptr), symbol(nullptr), arena(nullptr)
 {
 }
+
+
+/*
+ * Function:	Function::release
+ *
+ * Description:	Discard the statements, blocks, and temporaries of this
+ *		function.  Only the destructors of the objects still in use
+ *		are run, since they may own memory of their own, and then
+ *		the arena is released in one step.
+ */
+
+void Function::release()
+{
+    Label *label;
+
+
+    for (auto stmt : stmts)
+	if ((label = stmt->asLabel()) != nullptr && label->_block != nullptr)
+	    delete label->_block;
+
+    for (auto it = stmts.begin(); it != stmts.end(); )
+	delete *it ++;
+
+    stmts.clear();
+    entry = exit = nullptr;
+
+    if (Arena::current() == arena)
+	Arena::current(nullptr);
+
+    delete arena;
+    arena = nullptr;
+}
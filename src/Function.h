@@ -4,15 +4,46 @@
  * Description:	This file contains the class and variable declarations for
  *		a function, which is simply a container for related
  *		information about a given function.
+ *
+ *		The statements, blocks, and temporaries of a function are
+ *		allocated from its arena, and are discarded together once
+ *		the function has been compiled.  Statistics about
+ *		optimizing the function are kept with it.
+ *
+ *		A function that is small enough to be inlined keeps a copy
+ *		of its optimized statements, along with its parameters, in
+ *		an arena of its own that outlives the function's, so that
+ *		the copy is still available to the functions that follow.
+ *		Likewise, the global variables that a function may read or
+ *		write, directly or through the functions it calls, are
+ *		summarized so that its callers need not assume the worst.
  */
 
 # ifndef FUNCTION_H
 # define FUNCTION_H
 # include "Node.h"
+# include "Arena.h"
 # include "Block.h"
 # include "Scope.h"
+# include "stats.h"
 # include <unordered_map>
 
+struct Body {
+    Arena *arena;
+    Symbols parameters;
+    Statements stmts;
+    unsigned size;
+
+    Body() : arena(nullptr), size(0) {}
+};
+
+struct Effects {
+    bool known;
+    Symbols reads, writes;
+
+    Effects() : known(false) {}
+};
+
 struct Function {
     Node *body;
     Block *exit;
@@ -20,8 +51,13 @@ struct Function {
     Scope *locals;
     Symbol *symbol;
     Statements stmts;
+    Arena *arena;
+    Stats stats;
+    Body saved;
+    Effects effects;
 
     Function();
+    void release();
 };
 
 extern std::unordered_map<Symbol *, Function> functions;
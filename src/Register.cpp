@@ -2,7 +2,7 @@
  * File:	Register.cpp
  *
  * Description:	This file contains the member functions for registers on
- *		the Intel 32-bit processor.
+ *		the Intel 32-bit and x86-64 processors.
  */
 
 # include "Register.h"
@@ -16,8 +16,8 @@ using namespace std;
  * Description:	Initialize this register with its correct operand names.
  */
 
-Register::Register(const string &name, const string &byte)
-    : _name(name), _byte(byte), _symbol(nullptr), _dirty(false)
+Register::Register(const string &name, const string &byte, const string &quad)
+    : _name(name), _byte(byte), _quad(quad), _symbol(nullptr), _dirty(false)
 {
 }
 
@@ -30,7 +30,10 @@ Register::Register(const string &name, const string &byte)
 
 const string &Register::name(unsigned size) const
 {
-    return size == 1 ? _byte : _name;
+    if (size == 1)
+	return _byte;
+
+    return size == 8 ? _quad : _name;
 }
 
 
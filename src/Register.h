@@ -2,8 +2,9 @@
  * File:	Register.h
  *
  * Description:	This file contains the class definition for registers on
- *		the Intel 32-bit processor.  Each integer register has two
- *		operand names depending upon the access size.
+ *		the Intel 32-bit and x86-64 processors.  Each integer
+ *		register has up to three operand names depending upon the
+ *		access size.
  */
 
 # ifndef REGISTER_H
@@ -15,12 +16,14 @@ class Register {
     typedef std::string string;
     string _name;
     string _byte;
+    string _quad;
 
 public:
     class Symbol *_symbol;
     bool _dirty;
 
-    Register(const string &name, const string &byte = "");
+    Register(const string &name, const string &byte = "",
+	const string &quad = "");
     const string &name(unsigned size = 0) const;
     const string &byte() const;
 };
@@ -5,15 +5,17 @@
  *		three-address statements.
  */
 
+# include <cassert>
+# include <cstdlib>
 # include "tokens.h"
+# include "Arena.h"
 # include "Statement.h"
+# include "modref.h"
 # include "lvn.h"
 
 using namespace std;
 
-std::map<Symbol*, int> sym_int;
-std::map<struct LVN_expr*, int> expr_int;
-unsigned Label::_count = 0;
+atomic<unsigned> Label::_count(0);
 
 
 /*
@@ -28,6 +30,19 @@ static ostream &operator <<(ostream &ostr, Symbol *symbol)
 }
 
 
+/*
+ * Function:	Statement::operator new
+ *
+ * Description:	Allocate a statement from the current arena.
+ */
+
+void *Statement::operator new(size_t size)
+{
+    assert(Arena::current() != nullptr);
+    return Arena::current()->allocate(size);
+}
+
+
 /*
  * Function:	Statement::asLabel
  *
@@ -79,6 +94,60 @@ bool Statement::fallsThru() const
 }
 
 
+/*
+ * Function:	Statement::result (accessor)
+ *
+ * Description:	Default implementation to return the symbol assigned by
+ *		this statement.
+ */
+
+Symbol *Statement::result() const
+{
+    return nullptr;
+}
+
+
+/*
+ * Function:	Statement::result (mutator)
+ *
+ * Description:	Default implementation to update the symbol assigned by
+ *		this statement.
+ */
+
+void Statement::result(Symbol *sym)
+{
+}
+
+
+/*
+ * Function:	Statement::uses (accessor)
+ *
+ * Description:	Default implementation to return the number of operands
+ *		read by this statement.  The arrays of index and update
+ *		statements, and the function of a call, are not operands,
+ *		since they are never assigned.
+ */
+
+unsigned Statement::uses() const
+{
+    return 0;
+}
+
+
+/*
+ * Function:	Statement::use (accessor)
+ *
+ * Description:	Default implementation to return the given operand of this
+ *		statement, which has none.
+ */
+
+Symbol *&Statement::use(unsigned i)
+{
+    assert(0);
+    abort();
+}
+
+
 /*
  * Function:	Null::Null (constructor)
  *
@@ -123,7 +192,7 @@ Label::Label()
 
 void Label::write(ostream &ostr) const
 {
-    ostr << "L" << _number << ":" << endl;
+    ostr << "L" << _number << ":" << '\n';
 }
 
 
@@ -159,7 +228,7 @@ Jump::Jump(Label *target)
 
 void Jump::write(ostream &ostr) const
 {
-    ostr << "\tgoto L" << _target->_number << endl;
+    ostr << "\tgoto L" << _target->_number << '\n';
 }
 
 
@@ -221,7 +290,7 @@ Branch::Branch(int token, Symbol *left, Symbol *right, Label *target)
 void Branch::write(ostream &ostr) const
 {
     ostr << "\tif " << _left << " " << lexemes[_token] << " ";
-    ostr << _right << " goto L" << _target->_number << endl;
+    ostr << _right << " goto L" << _target->_number << '\n';
 }
 
 
@@ -256,7 +325,8 @@ void Branch::target(Label *tgt)
  */
 
 Call::Call(Symbol *result, Symbol *function, const Symbols &arguments)
-    : _result(result), _function(function), _arguments(arguments)
+    : _result(result), _function(function), _arguments(arguments),
+      _tail(false)
 {
 }
 
@@ -269,7 +339,9 @@ Call::Call(Symbol *result, Symbol *function, const Symbols &arguments)
 
 void Call::write(ostream &ostr) const
 {
-    if (_result != nullptr)
+    if (_tail)
+	ostr << "\treturn call " << _function << "(";
+    else if (_result != nullptr)
 	ostr << "\t" << _result << " := call " << _function << "(";
     else
 	ostr << "\tcall " << _function << "(";
@@ -277,7 +349,76 @@ void Call::write(ostream &ostr) const
     for (unsigned i = 0; i < _arguments.size(); i ++)
 	ostr << (i > 0 ? ", " : "") << _arguments[i];
 
-    ostr << ")" << endl;
+    ostr << ")" << '\n';
+}
+
+
+/*
+ * Function:	Call::fallsThru (predicate)
+ *
+ * Description:	Indicate whether control falls through from this
+ *		statement.  A tail call returns directly to our caller.
+ */
+
+bool Call::fallsThru() const
+{
+    return !_tail;
+}
+
+
+/*
+ * Function:	Call::availExpr
+ *
+ * Description:	Record the expressions killed by a call statement, which
+ *		are those involving its result, and those involving any
+ *		global variable the called function may assign.  The given
+ *		set holds those involving any global at all.
+ */
+
+void Call::availExpr(expr_set &gen, expr_set &kill,
+	const expr_universe &universe, const expr_set &globals)
+{
+    const Effects *effects = effectsOf(this);
+
+
+    kill |= universe.killed(_result);
+    gen -= universe.killed(_result);
+
+    if (effects == nullptr) {
+	kill |= globals;
+	gen -= globals;
+    } else
+	for (auto sym : effects->writes) {
+	    kill |= universe.killed(sym);
+	    gen -= universe.killed(sym);
+	}
+}
+
+
+/*
+ * Function:	Call::cp_gen_kill
+ *
+ * Description:	Record the copies killed by a call statement, in the same
+ *		manner as the expressions killed.
+ */
+
+void Call::cp_gen_kill(copy_set &gen, copy_set &kill,
+	const copy_universe &universe, const copy_set &globals)
+{
+    const Effects *effects = effectsOf(this);
+
+
+    kill |= universe.killed(_result);
+    gen -= universe.killed(_result);
+
+    if (effects == nullptr) {
+	kill |= globals;
+	gen -= globals;
+    } else
+	for (auto sym : effects->writes) {
+	    kill |= universe.killed(sym);
+	    gen -= universe.killed(sym);
+	}
 }
 
 
@@ -301,7 +442,7 @@ Return::Return(Symbol *expr)
 
 void Return::write(ostream &ostr) const
 {
-    ostr << "\treturn " << _expr << endl;
+    ostr << "\treturn " << _expr << '\n';
 }
 
 
@@ -339,7 +480,7 @@ Binary::Binary(int token, Symbol *result, Symbol *left, Symbol *right)
 void Binary::write(ostream &ostr) const
 {
     ostr << "\t" << _result << " := " << _left << " ";
-    ostr << lexemes[_token] << " " << _right << endl;
+    ostr << lexemes[_token] << " " << _right << '\n';
 }
 
 
@@ -364,7 +505,7 @@ Unary::Unary(int token, Symbol *result, Symbol *expr)
 void Unary::write(ostream &ostr) const
 {
     ostr << "\t" << _result << " := " << lexemes[_token] << " ";
-    ostr << _expr << endl;
+    ostr << _expr << '\n';
 }
 
 
@@ -388,7 +529,39 @@ Copy::Copy(Symbol *result, Symbol *expr)
 
 void Copy::write(ostream &ostr) const
 {
-    ostr << "\t" << _result << " := " << _expr << endl;
+    ostr << "\t" << _result << " := " << _expr << '\n';
+}
+
+
+/*
+ * Function:	Phi::Phi (constructor)
+ *
+ * Description:	Initialize a phi statement with one operand for each of
+ *		the given predecessors.  Each operand is initially the
+ *		result itself, until the statement is renamed.
+ */
+
+Phi::Phi(Symbol *result, const vector<Block *> &predecessors)
+    : _result(result), _operands(predecessors.size(), result),
+      _predecessors(predecessors)
+{
+}
+
+
+/*
+ * Function:	Phi::write
+ *
+ * Description:	Write a phi statement to the specified stream.
+ */
+
+void Phi::write(ostream &ostr) const
+{
+    ostr << "\t" << _result << " := phi(";
+
+    for (unsigned i = 0; i < _operands.size(); i ++)
+	ostr << (i > 0 ? ", " : "") << _operands[i];
+
+    ostr << ")" << '\n';
 }
 
 
@@ -412,7 +585,7 @@ Index::Index(Symbol *result, Symbol *array, Symbol *index)
 
 void Index::write(ostream &ostr) const
 {
-    ostr << "\t" << _result << " := " << _array << "[" << _index << "]" << endl;
+    ostr << "\t" << _result << " := " << _array << "[" << _index << "]" << '\n';
 }
 
 
@@ -436,7 +609,7 @@ Update::Update(Symbol *array, Symbol *index, Symbol *expr)
 
 void Update::write(ostream &ostr) const
 {
-    ostr << "\t" << _array << "[" << _index << "] := " << _expr << endl;
+    ostr << "\t" << _array << "[" << _index << "] := " << _expr << '\n';
 }
 
 
@@ -467,6 +640,166 @@ ostream &operator <<(ostream &ostr, const Statements &stmts)
     return ostr;
 }
 
+
+/*
+ * Function:	Statements::Statements (constructor)
+ *
+ * Description:	Initialize an empty list of statements.
+ */
+
+Statements::Statements()
+    : _size(0)
+{
+    _head._prev = _head._next = &_head;
+}
+
+
+/*
+ * Function:	Statements::Statements (move constructor)
+ *
+ * Description:	Initialize this list by taking the statements of another
+ *		list, which is left empty.
+ */
+
+Statements::Statements(Statements &&that)
+    : Statements()
+{
+    *this = std::move(that);
+}
+
+
+/*
+ * Function:	Statements::operator = (move assignment)
+ *
+ * Description:	Replace the statements in this list with those of another
+ *		list, which is left empty.
+ */
+
+Statements &Statements::operator =(Statements &&that)
+{
+    if (this != &that) {
+	clear();
+
+	if (!that.empty()) {
+	    _head._next = that._head._next;
+	    _head._prev = that._head._prev;
+	    _head._next->_prev = _head._prev->_next = &_head;
+	    _size = that._size;
+
+	    that._head._prev = that._head._next = &that._head;
+	    that._size = 0;
+	}
+    }
+
+    return *this;
+}
+
+
+/*
+ * Function:	Statements::link (private)
+ *
+ * Description:	Link a statement into this list before the given position.
+ */
+
+void Statements::link(StatementLink *pos, Statement *stmt)
+{
+    stmt->_next = pos;
+    stmt->_prev = pos->_prev;
+    pos->_prev->_next = stmt;
+    pos->_prev = stmt;
+    _size ++;
+}
+
+
+/*
+ * Function:	Statements::unlink (private)
+ *
+ * Description:	Unlink the statement at the given position from this list.
+ */
+
+void Statements::unlink(StatementLink *pos)
+{
+    assert(pos != &_head);
+
+    pos->_prev->_next = pos->_next;
+    pos->_next->_prev = pos->_prev;
+    _size --;
+}
+
+
+/*
+ * Function:	Statements::push_back
+ *
+ * Description:	Append a statement to the end of this list.
+ */
+
+void Statements::push_back(Statement *stmt)
+{
+    link(&_head, stmt);
+}
+
+
+/*
+ * Function:	Statements::insert
+ *
+ * Description:	Insert a statement before the given position and return
+ *		its position.
+ */
+
+Statements::iterator Statements::insert(iterator pos, Statement *stmt)
+{
+    link(pos._link, stmt);
+    return iterator(stmt);
+}
+
+
+/*
+ * Function:	Statements::erase
+ *
+ * Description:	Remove the statement at the given position, without
+ *		deleting it, and return the position of the next statement.
+ */
+
+Statements::iterator Statements::erase(iterator pos)
+{
+    StatementLink *next = pos._link->_next;
+
+    unlink(pos._link);
+    return iterator(next);
+}
+
+
+/*
+ * Function:	Statements::replace
+ *
+ * Description:	Replace the statement at the given position with another
+ *		statement, without deleting it, and return the position of
+ *		the new statement.
+ */
+
+Statements::iterator Statements::replace(iterator pos, Statement *stmt)
+{
+    StatementLink *next = pos._link->_next;
+
+    unlink(pos._link);
+    link(next, stmt);
+    return iterator(stmt);
+}
+
+
+/*
+ * Function:	Statements::clear
+ *
+ * Description:	Remove all statements from this list without deleting
+ *		them.
+ */
+
+void Statements::clear()
+{
+    _head._prev = _head._next = &_head;
+    _size = 0;
+}
+
 Statement *Binary::simplify() { 
 	// x + 0, 0 + x
 	if(_token == '+') {
@@ -482,9 +815,9 @@ Statement *Binary::simplify() {
 		} else if (_left->name() == "1") {
 			return new Copy(_result, _right);
 		} else if (_right->name() == "0") {
-			return new Copy(_result, new Symbol("0", Type(INT), NUM));
+			return new Copy(_result, makeLiteral(0));
 		} else if (_left->name() == "0") {
-			return new Copy(_result, new Symbol("0", Type(INT), NUM));
+			return new Copy(_result, makeLiteral(0));
 		}
 	// x - 0, 0 - x, x - x
 	} else if (_token == '-') {
@@ -493,22 +826,22 @@ Statement *Binary::simplify() {
 		} else if(_left->name() == "0") {
 			return new Unary(NEGATE,_result,_right);
 		} else if(_right->name() == _left->name()) {
-			return new Copy(_result, new Symbol("0", Type(INT), NUM));
+			return new Copy(_result, makeLiteral(0));
 		} 
 	// x / 1, 0 / x
 	} else if (_token == '/') {
 		if(_right->name() == "1") {
 			return new Copy(_result, _left);
 		} else if(_left->name() == "0") {
-			return new Copy(_result, new Symbol("0", Type(INT), NUM));
+			return new Copy(_result, makeLiteral(0));
 		}
 	} else if ((_token == EQL) || (_token == LEQ) || (_token == GEQ)) {
 		if(_right->name() == _left->name()) {
-			return new Copy(_result, new Symbol("1", Type(INT), NUM));
+			return new Copy(_result, makeLiteral(1));
 		} 
 	} else if ((_token == NEQ) || (_token == GTN) || (_token == LTN)) {
 		if(_right->name() == _left->name()) {
-			return new Copy(_result, new Symbol("0", Type(INT), NUM));
+			return new Copy(_result, makeLiteral(0));
 		}
 	}
 	return this;
@@ -524,11 +857,11 @@ Statement *Copy::simplify(){
 Statement *Branch::simplify(){
 	if((_token == EQL) || (_token == LEQ) || (_token == GEQ)) {
 		if(_left->name() == _right->name()) {
-			return new Branch(EQL, new Symbol("0", Type(INT), NUM), new Symbol("0", Type(INT), NUM), _target);
+			return new Branch(EQL, makeLiteral(0), makeLiteral(0), _target);
 		} 
 	} else if ((_token == NEQ) || (_token == GTN) || (_token == LTN)) {
 		if(_left->name() == _right->name()) {
-			return new Branch(EQL, new Symbol("1", Type(INT), NUM), new Symbol("0", Type(INT), NUM), _target);
+			return new Branch(EQL, makeLiteral(1), makeLiteral(0), _target);
 		}
 	}
 	return this;
@@ -583,218 +916,171 @@ Statement *Binary::cfold() {
 	if(isNumber(_left) && isNumber(_right)) {
 		if(_token == '+') {
 			res = stoi(_left->name()) + stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if (_token == '-') {
 			res = stoi(_left->name()) - stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if (_token == '*') {	
 			res = stoi(_left->name()) * stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if ((_token == '/') && (_right->name() != "0")) {
 			res = stoi(_left->name()) / stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if ((_token == '%') && (_right->name() != "0")) {
 			res = stoi(_left->name()) % stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if (_token == NEQ) {
 			res = stoi(_left->name()) != stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if (_token == EQL) {
 			res = stoi(_left->name()) == stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if (_token == GTN) {
 			res = stoi(_left->name()) > stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if (_token == LTN) {
 			res = stoi(_left->name()) < stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if (_token == LEQ) {
 			res = stoi(_left->name()) <= stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if (_token == GEQ) {
 			res = stoi(_left->name()) >= stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if (_token == AND) {
 			res = stoi(_left->name()) && stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} else if (_token == OR) {
 			res = stoi(_left->name()) || stoi(_right->name());
-			return new Copy(_result, new Symbol(to_string(res), Type(INT), NUM));
+			return new Copy(_result, makeLiteral(res));
 		} 
 	} 
 	return this;
 }
 
-Statement *Call::valnum(int &val_num) {
-	for(auto &symbol: lvn_globals) {
-		if(sym_int.count(symbol) > 0) {
-			sym_int.erase(symbol);
-		}
-	}
-	return this;	
+/*
+ * Function:	Call::valnum
+ *
+ * Description:	Value number a call statement.  The called function may
+ *		assign to any global variable, unless we know which ones
+ *		it may assign.
+ */
+
+Statement *Call::valnum(ValueTable &table)
+{
+    const Effects *effects = effectsOf(this);
+
+
+    if (effects == nullptr)
+	table.killGlobals();
+    else
+	for (auto sym : effects->writes)
+	    table.kill(sym);
+
+    if (_result != nullptr)
+	table.kill(_result);
+
+    return this;
 }
 
-Statement *Copy::valnum(int &val_num) {
-	if(sym_int.count(_expr) == 0) {
-		sym_int[_expr] = val_num;
-		sym_int[_result] = val_num;
-		val_num++;
-	} else {
-		sym_int[_result] = sym_int[_expr];
-	}
-	
-	return this;
+
+/*
+ * Function:	Copy::valnum
+ *
+ * Description:	Value number a copy statement.  The result simply takes
+ *		on the value number of the expression.
+ */
+
+Statement *Copy::valnum(ValueTable &table)
+{
+    table.assign(_result, table.number(_expr));
+    return this;
 }
 
-Statement *Binary::valnum(int &val_num) {
-	if(_token == '+' || _token == '*' || _token == EQL || _token == NEQ || _token == AND || _token == OR) {
-		if(sym_int.count(_left) == 0) {
-			sym_int[_left] = val_num++;
-		} 
-		if(sym_int.count(_right) == 0) {
-			sym_int[_right] = val_num++;
-		}
-		bool found = false;
-		int tnum = 0;
-		for(auto it = expr_int.begin(); (it != expr_int.end()) && (!found); it++) {
-			if(sym_int[_left] <= sym_int[_right]) {
-				if((it->first->left == sym_int[_left]) && (it->first->right == sym_int[_right]) && (it->first->op == _token)) {
-				found = true;
-				tnum = it->second;
-				}
-			} else {
-				if((it->first->left == sym_int[_right]) && (it->first->right == sym_int[_left]) && (it->first->op == _token)) {
-				found = true;
-				tnum = it->second;
-				}
-			}
-		}
-		if(found) {
-			for(auto it = sym_int.begin(); it != sym_int.end(); it++) {
-				if(it->second == tnum) {
-					sym_int[_result] = tnum;//val_num++;
-					return new Copy(_result, it->first);
-				}
-			}
-		} else {
-			lvn_expr = new LVN_expr;
-			if(sym_int[_left] <= sym_int[_right]) {
-				lvn_expr->left = sym_int[_left];
-				lvn_expr->right = sym_int[_right];
-			} else {
-				lvn_expr->left = sym_int[_right];
-				lvn_expr->right = sym_int[_left];
-			}
-			lvn_expr->op = _token;
-			expr_int[lvn_expr] = val_num;
-			sym_int[_result] = val_num++;
-			return this;
-		}
-	} else if(_token == GTN || _token == LTN || _token == GEQ || _token == LEQ) {
-        if(sym_int.count(_left) == 0) {
-            sym_int[_left] = val_num++;
-        }
-        if(sym_int.count(_right) == 0) {
-            sym_int[_right] = val_num++;
-        }
-		bool found = false;
-		int tnum = 0;
-        for(auto it = expr_int.begin(); (it != expr_int.end()) && (!found); it++) {
-			if(_token <= duals[_token]) {
-        		if((it->first->left == sym_int[_left]) && (it->first->right == sym_int[_right]) && (it->first->op == _token)) {
-            		found = true;
-            		tnum = it->second;
-            	} 
-			} else if ((it->first->left == sym_int[_right]) && (it->first->right == sym_int[_left]) && (it->first->op == duals[_token])){
-				found = true;
-				tnum = it->second;
-			}
-        }
-        if(found) {
-            for(auto it = sym_int.begin(); it != sym_int.end(); it++) {
-                if(it->second == tnum) {
-                    sym_int[_result] = tnum;//val_num++;
-                    return new Copy(_result, it->first);
-                }
-            }
-        } else {
-            lvn_expr = new LVN_expr;
-            if(_token <= duals[_token]) {
-                lvn_expr->left = sym_int[_left];
-                lvn_expr->right = sym_int[_right];
-				lvn_expr->op = _token;
-            } else {
-                lvn_expr->left = sym_int[_right];
-                lvn_expr->right = sym_int[_left];
-            	lvn_expr->op = duals[_token];
-            }
-            expr_int[lvn_expr] = val_num;
-            sym_int[_result] = val_num++;
-            return this;
-        }	
-	} else {
-		if(sym_int.count(_left) == 0) {
-			sym_int[_left] = val_num++;
-		} 
-		if(sym_int.count(_right) == 0) {
-			sym_int[_right] = val_num++;
-		}
-		bool found = false;
-		int tnum = 0;
-		for(auto it = expr_int.begin(); (it != expr_int.end()) && (!found); it++) {
-			if((it->first->left == sym_int[_left]) && (it->first->right == sym_int[_right]) && (it->first->op == _token)) {
-			found = true;
-			tnum = it->second;
-			}
-		}
-		if(found) {
-			for(auto it = sym_int.begin(); it != sym_int.end(); it++) {
-				if(it->second == tnum) {
-					sym_int[_result] = tnum;//val_num++;
-					return new Copy(_result, it->first);
-				}
-			}
-		} else {
-			lvn_expr = new LVN_expr;
-			lvn_expr->left = sym_int[_left];
-			lvn_expr->right = sym_int[_right];
-			lvn_expr->op = _token;
-			expr_int[lvn_expr] = val_num;
-			sym_int[_result] = val_num++;
-			return this;
-		}
-	}
 
-	return this;
+/*
+ * Function:	Binary::valnum
+ *
+ * Description:	Value number a binary statement.  If the value is already
+ *		held by some symbol, then the statement is replaced by a
+ *		copy of that symbol, or removed if that symbol is the
+ *		result itself.
+ */
+
+Statement *Binary::valnum(ValueTable &table)
+{
+    int value;
+    Symbol *sym;
+
+
+    value = table.number(_token, table.number(_left), table.number(_right));
+    sym = table.holder(value);
+
+    if (sym == _result)
+	return nullptr;
+
+    table.assign(_result, value);
+
+    if (sym != nullptr)
+	return new Copy(_result, sym);
+
+    return this;
 }
 
-Statement *Unary::valnum(int &val_num) {
-	bool found = false;
-	int tnum = 0;
-	if(sym_int.count(_expr) == 0) {
-		sym_int[_expr] = val_num++;
-	} 
-	for(auto it = expr_int.begin(); (it != expr_int.end() && !found); it++) {
-		if((it->first->left == -1) && (it->first->right == sym_int[_expr])) {
-			found = true;
-			tnum = it->second;
-		}
-	}
-	if(found) {
-		for(auto it = sym_int.begin(); it != sym_int.end(); it++) {
-            if(it->second == tnum) {
-            	sym_int[_result] = val_num++;
-                return new Copy(_result, it->first);
-        	}
-		}
-	} else {
-		lvn_expr->op = _token;
-		lvn_expr->left = -1;
-		lvn_expr->right = sym_int[_expr];
-		expr_int[lvn_expr] = val_num;
-		sym_int[_result] = val_num++;
-	}
-	return this;
+
+/*
+ * Function:	Unary::valnum
+ *
+ * Description:	Value number a unary statement in the same way as a
+ *		binary statement.
+ */
+
+Statement *Unary::valnum(ValueTable &table)
+{
+    int value;
+    Symbol *sym;
+
+
+    value = table.number(_token, table.number(_expr));
+    sym = table.holder(value);
+
+    if (sym == _result)
+	return nullptr;
+
+    table.assign(_result, value);
+
+    if (sym != nullptr)
+	return new Copy(_result, sym);
+
+    return this;
+}
+
+
+/*
+ * Function:	Phi::valnum
+ *
+ * Description:	Value number a phi statement.  The result merges values
+ *		from other blocks, so it is simply given an unknown value.
+ */
+
+Statement *Phi::valnum(ValueTable &table)
+{
+    table.kill(_result);
+    return this;
+}
+
+
+/*
+ * Function:	Index::valnum
+ *
+ * Description:	Value number an index statement.  Since arrays are not
+ *		value numbered, the result is simply given an unknown value.
+ */
+
+Statement *Index::valnum(ValueTable &table)
+{
+    table.kill(_result);
+    return this;
 }
 
 /*
@@ -9,7 +9,9 @@
 
 # ifndef STATEMENT_H
 # define STATEMENT_H
-# include <list>
+# include <atomic>
+# include <cstddef>
+# include <iterator>
 # include <ostream>
 # include <iostream>
 # include "Symbol.h"
@@ -17,32 +19,23 @@
 # include <unordered_set>
 # include "literal.h"
 # include <map>
-//# include "lvn.h"
+# include "lvn.h"
 # include "dataflow.h"
 
 struct Label;
-typedef std::list<class Statement *> Statements;
 
-typedef struct LVA_sets {
-    std::unordered_set<Symbol *> gen;
-	Symbol *kill;
-	int isFunc = 0;
-} LVA_sets;
-
-typedef struct avail_expr {
-	expr_set gen, kill;
-	
-} avail_expr;
-
-typedef struct cse_uni {
-	expr_set uni;
-} cse_uni;
+struct StatementLink {
+    StatementLink *_prev, *_next;
+};
 
-class Statement {
+class Statement : public StatementLink {
 protected:
     typedef std::ostream ostream;
 	
 public:
+    static void *operator new(std::size_t size);
+    static void operator delete(void *ptr) {}
+
     virtual ~Statement() {}
     virtual void write(ostream &ostr) const = 0;
     virtual void generate() = 0;
@@ -51,40 +44,102 @@ public:
     virtual Label *target() const;
     virtual void target(Label *tgt);
     virtual bool fallsThru() const;
-	virtual LVA_sets make_lva_sets() const = 0;
+
+    virtual Symbol *result() const;
+    virtual void result(Symbol *sym);
+    virtual unsigned uses() const;
+    virtual Symbol *&use(unsigned i);
+
 	virtual Statement *simplify() = 0;
 	virtual Statement *cfold() = 0;
-	virtual Statement *valnum(int &val_num) = 0;
+	virtual Statement *valnum(ValueTable &table) = 0;
 	//virtual copy_set gen_uni() = 0;
 	// cse
-	virtual avail_expr availExpr(cse_uni universe) { avail_expr cur; return cur;};
-	virtual void gen_cse_uni(cse_uni &universe) {return;}
-	virtual Statement *cse_prop() {return this;}
-	virtual void cp_uni(copy_set &universe) { return;}
-	virtual void cp_gen_kill(copy_set &gen, copy_set &kill, copy_set &universe, Symbols globals) {return;}
-	virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, copy_set &universe) {return false;}
+	virtual void availExpr(expr_set &gen, expr_set &kill, const expr_universe &universe, const expr_set &globals) {return;}
+	virtual void gen_cse_uni(expr_universe &universe) {return;}
+	virtual void cp_uni(copy_universe &universe) { return;}
+	virtual void cp_gen_kill(copy_set &gen, copy_set &kill, const copy_universe &universe, const copy_set &globals) {return;}
+	virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, const copy_universe &universe) {return false;}
 }; 
 
 
+/*
+ * Statements are kept in an intrusive doubly-linked list, which behaves
+ * like a std::list<Statement *>, except that a statement can belong to
+ * at most one list and that the list never deletes its statements.
+ */
+
+class Statements {
+    StatementLink _head;
+    unsigned _size;
+
+    void link(StatementLink *pos, Statement *stmt);
+    void unlink(StatementLink *pos);
+
+public:
+    class iterator {
+	StatementLink *_link;
+	friend class Statements;
+
+    public:
+	typedef std::bidirectional_iterator_tag iterator_category;
+	typedef Statement *value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef Statement **pointer;
+	typedef Statement *reference;
+
+	iterator(StatementLink *link = nullptr) : _link(link) {}
+
+	Statement *operator *() const { return static_cast<Statement *>(_link); }
+	iterator &operator ++() { _link = _link->_next; return *this; }
+	iterator &operator --() { _link = _link->_prev; return *this; }
+	iterator operator ++(int) { iterator it = *this; ++ *this; return it; }
+	iterator operator --(int) { iterator it = *this; -- *this; return it; }
+
+	bool operator ==(const iterator &it) const { return _link == it._link; }
+	bool operator !=(const iterator &it) const { return _link != it._link; }
+    };
+
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+
+    Statements();
+    Statements(Statements &&that);
+    Statements &operator =(Statements &&that);
+
+    Statements(const Statements &) = delete;
+    Statements &operator =(const Statements &) = delete;
+
+    iterator begin() const { return iterator(_head._next); }
+    iterator end() const { return iterator(const_cast<StatementLink *>(&_head)); }
+    reverse_iterator rbegin() const { return reverse_iterator(end()); }
+    reverse_iterator rend() const { return reverse_iterator(begin()); }
+
+    unsigned size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    Statement *front() const { return *begin(); }
+    Statement *back() const { return *std::prev(end()); }
+
+    void push_back(Statement *stmt);
+    iterator insert(iterator pos, Statement *stmt);
+    iterator erase(iterator pos);
+    iterator replace(iterator pos, Statement *stmt);
+    void clear();
+};
+
+
 struct Null : public Statement {
     Null();
     virtual void write(ostream &ostr) const;
     virtual void generate();
-	virtual LVA_sets make_lva_sets() const {
-		LVA_sets sets;
-		//sets.kill.insert(nullptr);
-		sets.kill = nullptr;
-		return sets;
-	}
 	
 	virtual Statement *simplify() { return this;}
 	virtual Statement *cfold() { return this;}
-	virtual Statement *valnum(int &val_num) { return this; }
+	virtual Statement *valnum(ValueTable &table) { return this; }
 };
 
 
 struct Label : public Statement {
-    static unsigned _count;
+    static std::atomic<unsigned> _count;
     unsigned _number;
     struct Block *_block;
 
@@ -95,15 +150,9 @@ struct Label : public Statement {
     virtual void generate();
 
     virtual Label *asLabel() const;
-	virtual LVA_sets make_lva_sets() const {
-		LVA_sets sets;
-		//sets.kill.insert(nullptr);
-		sets.kill = nullptr;
-		return sets;
-	}
 	virtual Statement *simplify() { return this;}
 	virtual Statement *cfold() { return this;}
-	virtual Statement *valnum(int &val_num) { return this; }
+	virtual Statement *valnum(ValueTable &table) { return this; }
 };
 
 
@@ -117,15 +166,9 @@ struct Jump : public Statement {
     virtual Label *target() const;
     virtual void target(Label *tgt);
     virtual bool fallsThru() const;
-	virtual LVA_sets make_lva_sets() const {
-		LVA_sets sets;
-		//sets.kill.insert(nullptr);
-		sets.kill = nullptr;
-		return sets;
-	}
 	virtual Statement *simplify() { return this;}
 	virtual Statement *cfold() { return this;}
-	virtual Statement *valnum(int &val_num) { return this; }
+	virtual Statement *valnum(ValueTable &table) { return this; }
 };
 
 
@@ -138,32 +181,18 @@ struct Branch : public Statement {
     virtual void write(ostream &ostr) const;
     virtual void generate();
 
+    virtual unsigned uses() const { return 2; }
+    virtual Symbol *&use(unsigned i) { return i == 0 ? _left : _right; }
+
     virtual Label *target() const;
     virtual void target(Label *tgt);
-	virtual LVA_sets make_lva_sets() const {
-		LVA_sets sets;
-		sets.gen.insert(_left);
-		sets.gen.insert(_right);
-		//sets.kill.insert(nullptr);
-		sets.kill = nullptr;
-		return sets;
-	}
 	virtual Statement *simplify(); //{ return this;}
 	virtual Statement *cfold();// { return this;}
-	virtual Statement *valnum(int &val_num) { return this; }
+	virtual Statement *valnum(ValueTable &table) { return this; }
 	
-    virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, copy_set &universe) {
-        bool changed = false;
-        for(auto &pair : gen) {
-            if(_left == pair.first) {
-                _left = pair.second;
-                changed = true;
-            }
-            if(_right == pair.first) {
-                _right = pair.second;
-                changed = true;
-            }
-        }
+    virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, const copy_universe &universe) {
+        bool changed = propagate(_left, gen, universe);
+        changed = propagate(_right, gen, universe) || changed;
         return changed;
     }
 
@@ -173,62 +202,29 @@ struct Branch : public Statement {
 struct Call : public Statement {
     Symbol *_result, *_function;
     Symbols _arguments;
+    bool _tail;
 
     Call(Symbol *result, Symbol *function, const Symbols &arguments);
     virtual void write(ostream &ostr) const;
     virtual void generate();
-	virtual LVA_sets make_lva_sets() const {
-		LVA_sets sets;
-		for (auto &i : _arguments) {
-			if (!isNumber(i) && (i->kind() != STRLIT)) {
-				sets.gen.insert(i);
-			}
-		}
-		//sets.kill.insert(_result);
-		//sets.gen = _arguments;
-		sets.isFunc = 1;
-		sets.kill = _result;
-		return sets;
-	}
+
+    virtual bool fallsThru() const;
+
+    virtual Symbol *result() const { return _result; }
+    virtual void result(Symbol *sym) { _result = sym; }
+    virtual unsigned uses() const { return _arguments.size(); }
+    virtual Symbol *&use(unsigned i) { return _arguments[i]; }
 	virtual Statement *simplify() { return this;}
 	virtual Statement *cfold() { return this;}
-	virtual Statement *valnum(int &val_num); //{ return this; }
-	
-	
-    virtual void cp_gen_kill(copy_set &gen, copy_set &kill, copy_set &universe, Symbols globals) {
-
-        for(auto &pair : universe) {
-            if(pair.first == _result || pair.second == _result) {
-                kill.insert(pair);
-                if(gen.count(pair) > 0)
-                    gen.erase(pair);
-            }
-        }
-
-		for(auto &sym : globals) {
-			if(sym->kind() == GLOBAL && !(sym->type().isFunction())) {
-				for(auto &pair : universe) {
-					if(sym == pair.first || sym == pair.second) {
-						kill.insert(pair);
-						gen.erase(pair);
-					}
-				}
-			}
-		}
-
-        return;
-    }
+	virtual Statement *valnum(ValueTable &table);
+	virtual void availExpr(expr_set &gen, expr_set &kill, const expr_universe &universe, const expr_set &globals);
+    virtual void cp_gen_kill(copy_set &gen, copy_set &kill, const copy_universe &universe, const copy_set &globals);
 
 	
-	virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, copy_set &universe) {
+	virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, const copy_universe &universe) {
 		bool changed = false;
 		for(auto &arg : _arguments) {
-			for(auto &pair : gen) {
-				if(arg == pair.first){
-					arg = pair.second;
-					changed = true;
-				}
-			}
+			changed = propagate(arg, gen, universe) || changed;
 		}
 
 		return changed;
@@ -243,27 +239,15 @@ struct Return : public Statement {
     virtual void write(ostream &ostr) const;
     virtual void generate();
 
+    virtual unsigned uses() const { return _expr != nullptr ? 1 : 0; }
+    virtual Symbol *&use(unsigned i) { return _expr; }
+
     virtual bool fallsThru() const;
-	virtual LVA_sets make_lva_sets() const {
-		LVA_sets sets;
-		sets.gen.insert(_expr);
-		//sets.kill.insert(nullptr);
-		sets.kill = nullptr;
-		
-		return sets;
-	}
 	virtual Statement *simplify() { return this;}
 	virtual Statement *cfold() { return this;}
-	virtual Statement *valnum(int &val_num) { return this; }
-	virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, copy_set &universe) {
-		bool changed = false;
-		for(auto &pair : gen) {
-			if(_expr == pair.first) {
-				_expr = pair.second;
-				changed = true;
-			}
-		}
-		return changed;
+	virtual Statement *valnum(ValueTable &table) { return this; }
+	virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, const copy_universe &universe) {
+		return propagate(_expr, gen, universe);
 	}
 };
 
@@ -271,75 +255,40 @@ struct Return : public Statement {
 struct Binary : public Statement {
     int _token;
     Symbol *_result, *_left, *_right;
-	struct LVN_expr *lvn_expr;
 	
 	
     Binary(int token, Symbol *result, Symbol *left, Symbol *right);
     virtual void write(ostream &ostr) const;
     virtual void generate();
-	virtual LVA_sets make_lva_sets() const {
-		LVA_sets sets;
-		sets.gen.insert(_left);
-		sets.gen.insert(_right);
-		//sets.kill.insert(_result);
-		sets.kill = _result;
-		return sets;
-	}
+
+    virtual Symbol *result() const { return _result; }
+    virtual void result(Symbol *sym) { _result = sym; }
+    virtual unsigned uses() const { return 2; }
+    virtual Symbol *&use(unsigned i) { return i == 0 ? _left : _right; }
 	virtual Statement *simplify();
 	virtual Statement *cfold();
-	virtual Statement *valnum(int &val_num); //{return this;}
-	virtual avail_expr availExpr(cse_uni universe) {
-		avail_expr cur;
-		struct expr_tuple gen;
-		gen._left = _left;
-		gen._right = _right;
-		gen._token = _token;
-		cur.gen.insert(gen);
-		for(auto &i : universe.uni) {
-			if(_result == i._left || _result == i._right) {
-				//TODO this might have errors
-				cur.kill.insert(i);
-			}
-		}
-		
-		return cur;
+	virtual Statement *valnum(ValueTable &table);
+	virtual void availExpr(expr_set &gen, expr_set &kill, const expr_universe &universe, const expr_set &globals) {
+		int expr = universe.find(expr_tuple{_left, _right, _token});
+		if(expr >= 0)
+			gen.set(expr);
+		kill |= universe.killed(_result);
+		gen -= universe.killed(_result);
 	}
-	virtual void gen_cse_uni(cse_uni &universe) {
-		struct expr_tuple *temp = new struct expr_tuple;
-		temp->_left = _left;
-		temp->_right = _right;
-		temp->_token = _token;
-		universe.uni.insert(*temp);
-	}
-	virtual Statement *cse_prop() {
-	
-		return this;
+	virtual void gen_cse_uni(expr_universe &universe) {
+		universe.insert(expr_tuple{_left, _right, _token});
 	}
 
-	virtual void cp_gen_kill(copy_set &gen, copy_set &kill, copy_set &universe, Symbols globals) {
+	virtual void cp_gen_kill(copy_set &gen, copy_set &kill, const copy_universe &universe, const copy_set &globals) {
 		
-		for(auto &pair : universe) {
-			if(pair.first == _result || pair.second == _result) {
-				kill.insert(pair);
-				if(gen.count(pair) > 0)
-					gen.erase(pair);
-			}
-		}
+		kill |= universe.killed(_result);
+		gen -= universe.killed(_result);
 
 		return;
 	}
-	virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, copy_set &universe) {
-		bool changed = false;
-		for(auto &pair : gen) {
-			if(_left == pair.first) {
-				_left = pair.second;
-				changed = true;
-			}
-			if(_right == pair.first) {
-				_right = pair.second;
-				changed = true;
-			}
-		}
+	virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, const copy_universe &universe) {
+		bool changed = propagate(_left, gen, universe);
+		changed = propagate(_right, gen, universe) || changed;
 		return changed;
 	}
 };
@@ -348,55 +297,35 @@ struct Binary : public Statement {
 struct Unary : public Statement {
     int _token;
     Symbol *_result, *_expr;
-	struct LVN_expr *lvn_expr;
     
 	Unary(int token, Symbol *result, Symbol *expr);
     virtual void write(ostream &ostr) const;
     virtual void generate();
-	virtual struct LVA_sets make_lva_sets() const {
-		LVA_sets sets;
-		sets.gen.insert(_expr);
-		sets.kill = _result;
-		//sets.kill.insert(nullptr);
-		return sets;
-	}
+
+    virtual Symbol *result() const { return _result; }
+    virtual void result(Symbol *sym) { _result = sym; }
+    virtual unsigned uses() const { return 1; }
+    virtual Symbol *&use(unsigned i) { return _expr; }
 	virtual Statement *simplify() { return this;}
 	virtual Statement *cfold() { return this;}
-	virtual Statement *valnum(int &val_num); //{ return this; }
-	virtual avail_expr availExpr(cse_uni universe) {
-		avail_expr cur;
-		for(auto &i : universe.uni) {
-			if(_result == i._left || _result == i._right) {
-				cur.kill.insert(i);
-			}
-		}
-		return cur;
+	virtual Statement *valnum(ValueTable &table);
+	virtual void availExpr(expr_set &gen, expr_set &kill, const expr_universe &universe, const expr_set &globals) {
+		kill |= universe.killed(_result);
+		gen -= universe.killed(_result);
 	}
 
 	
-    virtual void cp_gen_kill(copy_set &gen, copy_set &kill, copy_set &universe, Symbols globals) {
+    virtual void cp_gen_kill(copy_set &gen, copy_set &kill, const copy_universe &universe, const copy_set &globals) {
 
-        for(auto &pair : universe) {
-            if(pair.first == _result || pair.second == _result) {
-                kill.insert(pair);
-                if(gen.count(pair) > 0)
-                    gen.erase(pair);
-            }
-        }
+        kill |= universe.killed(_result);
+        gen -= universe.killed(_result);
 
         return;
     }
 
 	
-    virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, copy_set &universe) {
-        bool changed = false;
-        for(auto &pair : gen) {
-            if(_expr == pair.first) {
-                _expr = pair.second;
-                changed = true;
-            }
-        }
-        return changed;
+    virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, const copy_universe &universe) {
+        return propagate(_expr, gen, universe);
     }
 
 };
@@ -408,54 +337,62 @@ struct Copy : public Statement {
     Copy(Symbol *result, Symbol *expr);
     virtual void write(ostream &ostr) const;
     virtual void generate();
-	virtual struct LVA_sets make_lva_sets() const {
-		LVA_sets sets;
-		sets.gen.insert(_expr);
-		//sets.kill.insert(_result);
-		sets.kill = _result;
-		return sets;
-	}
+
+    virtual Symbol *result() const { return _result; }
+    virtual void result(Symbol *sym) { _result = sym; }
+    virtual unsigned uses() const { return 1; }
+    virtual Symbol *&use(unsigned i) { return _expr; }
 	virtual Statement *simplify();
 	virtual Statement *cfold() { return this;}
-	virtual Statement *valnum(int &val_num); //{ return this;}
-	virtual avail_expr availExpr(cse_uni universe) {
-		avail_expr cur;
-		for(auto &i : universe.uni) {
-			if(_result == i._left || _result == i._right) {
-				cur.kill.insert(i);
-			}
-		}
-		return cur;
+	virtual Statement *valnum(ValueTable &table);
+	virtual void availExpr(expr_set &gen, expr_set &kill, const expr_universe &universe, const expr_set &globals) {
+		kill |= universe.killed(_result);
+		gen -= universe.killed(_result);
 	}
-	virtual void cp_uni(copy_set &universe) { 
+	virtual void cp_uni(copy_universe &universe) { 
 		
 		universe.insert(copy_pair(_result, _expr));
 		return;
 	}
-	virtual void cp_gen_kill(copy_set &gen, copy_set &kill, copy_set &universe, Symbols globals) {
+	virtual void cp_gen_kill(copy_set &gen, copy_set &kill, const copy_universe &universe, const copy_set &globals) {
 		
-		kill.insert(copy_pair(_result, _expr));
-		for(auto &pair : universe) {
-			if(pair.first == _result || pair.second == _result) {
-				kill.insert(pair);
-				gen.erase(pair);
-			}
-		}
-		gen.insert(copy_pair(_result, _expr));
+		int copy = universe.find(copy_pair(_result, _expr));
+		kill |= universe.killed(_result);
+		gen -= universe.killed(_result);
+		if(copy >= 0)
+			gen.set(copy);
 
 		return;
 	}
-	virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, copy_set &universe) {
-		bool changed = false;
-		
-		for(auto &pair : gen) {
-			if(_expr == pair.first){
-				_expr = pair.second;
-				changed = true;
-			}
-		}
+	virtual bool cprop(copy_set &gen, copy_set &kill, copy_set &in, const copy_universe &universe) {
+		return propagate(_expr, gen, universe);
+	}
+};
 
-		return changed;
+
+struct Phi : public Statement {
+    Symbol *_result;
+    Symbols _operands;
+    std::vector<struct Block *> _predecessors;
+
+    Phi(Symbol *result, const std::vector<struct Block *> &predecessors);
+    virtual void write(ostream &ostr) const;
+    virtual void generate();
+
+    virtual Symbol *result() const { return _result; }
+    virtual void result(Symbol *sym) { _result = sym; }
+    virtual unsigned uses() const { return _operands.size(); }
+    virtual Symbol *&use(unsigned i) { return _operands[i]; }
+	virtual Statement *simplify() { return this;}
+	virtual Statement *cfold() { return this;}
+	virtual Statement *valnum(ValueTable &table);
+	virtual void availExpr(expr_set &gen, expr_set &kill, const expr_universe &universe, const expr_set &globals) {
+		kill |= universe.killed(_result);
+		gen -= universe.killed(_result);
+	}
+	virtual void cp_gen_kill(copy_set &gen, copy_set &kill, const copy_universe &universe, const copy_set &globals) {
+		kill |= universe.killed(_result);
+		gen -= universe.killed(_result);
 	}
 };
 
@@ -466,16 +403,18 @@ struct Index : public Statement {
     Index(Symbol *result, Symbol *array, Symbol *index);
     virtual void write(ostream &ostr) const;
     virtual void generate();
-	virtual struct LVA_sets make_lva_sets() const {
-		LVA_sets sets;
-		sets.gen.insert(_index);
-		//sets.kill.insert(_result);
-		sets.kill = _result;
-		return sets;
-	}
+
+    virtual Symbol *result() const { return _result; }
+    virtual void result(Symbol *sym) { _result = sym; }
+    virtual unsigned uses() const { return 1; }
+    virtual Symbol *&use(unsigned i) { return _index; }
 	virtual Statement *simplify() { return this;}
 	virtual Statement *cfold() { return this;}
-	virtual Statement *valnum(int &val_num) { return this; }
+	virtual Statement *valnum(ValueTable &table);
+	virtual void availExpr(expr_set &gen, expr_set &kill, const expr_universe &universe, const expr_set &globals) {
+		kill |= universe.killed(_result);
+		gen -= universe.killed(_result);
+	}
 };
 
 
@@ -485,17 +424,12 @@ struct Update : public Statement {
     Update(Symbol *array, Symbol *index, Symbol *expr);
     virtual void write(ostream &ostr) const;
     virtual void generate();
-	virtual struct LVA_sets make_lva_sets() const {
-		LVA_sets sets;
-		sets.gen.insert(_index);
-		sets.gen.insert(_expr);
-		//sets.kill.insert(nullptr);
-		sets.kill = nullptr;
-		return sets;
-	}
+
+    virtual unsigned uses() const { return 2; }
+    virtual Symbol *&use(unsigned i) { return i == 0 ? _index : _expr; }
 	virtual Statement *simplify() { return this;}
 	virtual Statement *cfold() { return this;}
-	virtual Statement *valnum(int &val_num) { return this; }
+	virtual Statement *valnum(ValueTable &table) { return this; }
 };
 
 std::ostream &operator <<(std::ostream &ostr, Statement *stmt);
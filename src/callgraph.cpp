@@ -0,0 +1,138 @@
+/*
+ * File:	callgraph.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for building the call graph.
+ *
+ *		The components are found with Tarjan's algorithm, which
+ *		completes each component only after every component
+ *		reachable from it, so they are found bottom-up.  Each
+ *		component records the components that call it and the
+ *		number of components it calls, other than itself, so that
+ *		a scheduler can tell when it is ready to be compiled.
+ *
+ *		Since Tiny C has no prototypes, a function can only call
+ *		itself and the functions defined before it, and so every
+ *		component is a single function.  Nothing here relies on
+ *		that, however.
+ */
+
+# include <algorithm>
+# include <unordered_map>
+# include "callgraph.h"
+
+using namespace std;
+
+struct Search {
+    vector<vector<unsigned>> edges;
+    vector<unsigned> index, lowlink, component;
+    vector<unsigned> stack;
+    vector<bool> onstack;
+    unsigned count;
+};
+
+
+/*
+ * Function:	visit (private)
+ *
+ * Description:	Visit the given node in the search for strongly connected
+ *		components, adding each component found to the graph.
+ */
+
+static void visit(unsigned node, Search &search, CallGraph &graph)
+{
+    unsigned member;
+
+
+    search.index[node] = search.lowlink[node] = ++ search.count;
+    search.stack.push_back(node);
+    search.onstack[node] = true;
+
+    for (auto succ : search.edges[node])
+	if (search.index[succ] == 0) {
+	    visit(succ, search, graph);
+	    search.lowlink[node] = min(search.lowlink[node], search.lowlink[succ]);
+	} else if (search.onstack[succ])
+	    search.lowlink[node] = min(search.lowlink[node], search.index[succ]);
+
+    if (search.lowlink[node] != search.index[node])
+	return;
+
+    graph.components.push_back(vector<unsigned>());
+
+    do {
+	member = search.stack.back();
+	search.stack.pop_back();
+	search.onstack[member] = false;
+	search.component[member] = graph.components.size() - 1;
+	graph.components.back().push_back(member);
+    } while (member != node);
+
+    sort(graph.components.back().begin(), graph.components.back().end());
+}
+
+
+/*
+ * Function:	buildCallGraph
+ *
+ * Description:	Build the call graph of the given functions, whose
+ *		statements have been translated.  The components are
+ *		numbered bottom-up, and the functions in each component are
+ *		listed in the given order.  Calls to other functions are
+ *		ignored.
+ */
+
+CallGraph buildCallGraph(const vector<Function *> &defined)
+{
+    Call *call;
+    CallGraph graph;
+    Search search;
+    unsigned count, from, to;
+    unordered_map<Symbol *, unsigned> nodes;
+
+
+    count = defined.size();
+
+    for (unsigned i = 0; i < count; i ++)
+	nodes[defined[i]->symbol] = i;
+
+    search.edges.resize(count);
+    search.index.assign(count, 0);
+    search.lowlink.assign(count, 0);
+    search.component.assign(count, 0);
+    search.onstack.assign(count, false);
+    search.count = 0;
+
+    for (unsigned i = 0; i < count; i ++)
+	for (auto stmt : defined[i]->stmts)
+	    if ((call = dynamic_cast<Call *>(stmt)) != nullptr) {
+		auto it = nodes.find(call->_function);
+
+		if (it != nodes.end())
+		    search.edges[i].push_back(it->second);
+	    }
+
+    for (unsigned i = 0; i < count; i ++)
+	if (search.index[i] == 0)
+	    visit(i, search, graph);
+
+    graph.callers.resize(graph.components.size());
+    graph.callees.assign(graph.components.size(), 0);
+
+    for (unsigned i = 0; i < count; i ++)
+	for (auto succ : search.edges[i]) {
+	    from = search.component[i];
+	    to = search.component[succ];
+
+	    if (from == to)
+		continue;
+
+	    if (find(graph.callers[to].begin(), graph.callers[to].end(),
+		    from) == graph.callers[to].end()) {
+		graph.callers[to].push_back(from);
+		graph.callees[from] ++;
+	    }
+	}
+
+    return graph;
+}
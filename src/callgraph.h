@@ -0,0 +1,30 @@
+/*
+ * File:	callgraph.h
+ *
+ * Description:	This file contains the structure definition for the call
+ *		graph and the public function declaration for building it.
+ *
+ *		The nodes of the graph are the given functions, and there
+ *		is an edge from each function to each of those it calls.
+ *		The graph is condensed into its strongly connected
+ *		components, the sets of functions that call each other,
+ *		which are listed bottom-up, with each component after those
+ *		it calls.  A component may be compiled once those it calls
+ *		have been, so components that do not call each other may be
+ *		compiled at the same time.
+ */
+
+# ifndef CALLGRAPH_H
+# define CALLGRAPH_H
+# include <vector>
+# include "Function.h"
+
+struct CallGraph {
+    std::vector<std::vector<unsigned>> components;
+    std::vector<std::vector<unsigned>> callers;
+    std::vector<unsigned> callees;
+};
+
+CallGraph buildCallGraph(const std::vector<Function *> &defined);
+
+# endif /* CALLGRAPH_H */
@@ -1,12 +1,77 @@
 # ifndef DATAFLOW_H
 # define DATAFLOW_H
-# include <ostream>
-# include <unordered_set>
+# include <cassert>
+# include <utility>
+# include <vector>
+# include <unordered_map>
 # include "Symbol.h"
+# include "BitVector.h"
+
+/*
+ * A universe assigns each distinct element a dense index, so that a set
+ * of elements can be represented as a bit vector.  For the universes of
+ * copies and expressions, we also record for each symbol the elements
+ * that mention it, which are exactly those killed by assigning to it.
+ */
+
+template<class Key, class Hash = std::hash<Key> >
+class Universe {
+    std::vector<Key> _keys;
+    std::unordered_map<Key, unsigned, Hash> _index;
+    std::unordered_map<Symbol *, BitVector> _killed;
+    BitVector _none;
+
+public:
+    unsigned size() const { return _keys.size(); }
+    const Key &operator [](unsigned i) const { return _keys[i]; }
+
+    unsigned insert(const Key &key) {
+	auto it = _index.find(key);
+
+	if (it != _index.end())
+	    return it->second;
+
+	_keys.push_back(key);
+	return _index[key] = _keys.size() - 1;
+    }
+
+    int find(const Key &key) const {
+	auto it = _index.find(key);
+	return it != _index.end() ? (int) it->second : -1;
+    }
+
+    void clear() {
+	_keys.clear();
+	_index.clear();
+	_killed.clear();
+    }
+
+    void index() {
+	_killed.clear();
+	_none = BitVector(size());
+
+	for (unsigned i = 0; i < _keys.size(); i ++)
+	    for (auto sym : operands(_keys[i])) {
+		auto it = _killed.find(sym);
+
+		if (it == _killed.end())
+		    it = _killed.emplace(sym, BitVector(size())).first;
+
+		it->second.set(i);
+	    }
+    }
+
+    const BitVector &killed(Symbol *sym) const {
+	auto it = _killed.find(sym);
+	return it != _killed.end() ? it->second : _none;
+    }
+};
+
 
 /* For live variable analysis */
 
-typedef std::unordered_set<Symbol *> sym_set;
+typedef BitVector sym_set;
+typedef Universe<Symbol *> sym_universe;
 
 
 /* For available copies */
@@ -19,7 +84,30 @@ struct pair_hash {
 };
 
 typedef std::pair<class Symbol *, class Symbol *> copy_pair;
-typedef std::unordered_set<copy_pair, pair_hash> copy_set;
+typedef BitVector copy_set;
+typedef Universe<copy_pair, pair_hash> copy_universe;
+
+inline std::vector<Symbol *> operands(const copy_pair &copy)
+{
+    return {copy.first, copy.second};
+}
+
+
+/* Replace a symbol with its copy if one is available */
+
+inline bool propagate(Symbol *&sym, const copy_set &avail,
+	const copy_universe &universe)
+{
+    const copy_set &copies = universe.killed(sym);
+
+    for (unsigned i = copies.first(); i < copies.size(); i = copies.next(i))
+	if (avail.test(i) && universe[i].first == sym) {
+	    sym = universe[i].second;
+	    return true;
+	}
+
+    return false;
+}
 
 
 /* For available expressions */
@@ -39,71 +127,36 @@ struct expr_hash {
     }
 };
 
-typedef std::unordered_set<expr_tuple, expr_hash> expr_set;
-
-
-/* Destructive set union: s1 = s1 + s2 */
+typedef BitVector expr_set;
+typedef Universe<expr_tuple, expr_hash> expr_universe;
 
-template<class Key,
-    class Hash = std::hash<Key>,
-    class Pred = std::equal_to<Key>,
-    class Alloc = std::allocator<Key> >
-void insert(std::unordered_set<Key, Hash, Pred, Alloc> &s1,
-	const std::unordered_set<Key, Hash, Pred, Alloc> &s2)
+inline std::vector<Symbol *> operands(const expr_tuple &expr)
 {
-    s1.insert(s2.begin(), s2.end());
+    return {expr._left, expr._right};
 }
 
 
-/* Destructive set difference: s1 = s1 - s2 */
+/* Destructive set union: s1 = s1 + s2 */
 
-template<class Key,
-    class Hash = std::hash<Key>,
-    class Pred = std::equal_to<Key>,
-    class Alloc = std::allocator<Key> >
-void remove(std::unordered_set<Key, Hash, Pred, Alloc> &s1,
-	const std::unordered_set<Key, Hash, Pred, Alloc> &s2)
+inline void insert(BitVector &s1, const BitVector &s2)
 {
-    for (auto it = s2.begin(); it != s2.end(); it ++)
-	s1.erase(*it);
+    s1 |= s2;
 }
 
 
-/* Destructive set intersection: s1 = s1 * s2 */
+/* Destructive set difference: s1 = s1 - s2 */
 
-template<class Key,
-    class Hash = std::hash<Key>,
-    class Pred = std::equal_to<Key>,
-    class Alloc = std::allocator<Key> >
-void filter(std::unordered_set<Key, Hash, Pred, Alloc> &s1,
-	const std::unordered_set<Key, Hash, Pred, Alloc> &s2)
+inline void remove(BitVector &s1, const BitVector &s2)
 {
-    auto it = s1.begin();
-
-    while (it != s1.end())
-	if (s2.count(*it))
-	    it ++;
-	else
-	    it = s1.erase(it);
+    s1 -= s2;
 }
 
 
-/* Write a set to a stream */
+/* Destructive set intersection: s1 = s1 * s2 */
 
-template<class Key,
-    class Hash = std::hash<Key>,
-    class Pred = std::equal_to<Key>,
-    class Alloc = std::allocator<Key> >
-std::ostream &operator <<(std::ostream &ostr,
-	const std::unordered_set<Key, Hash, Pred, Alloc> &s)
+inline void filter(BitVector &s1, const BitVector &s2)
 {
-    ostr << "{";
-
-    for (auto it = s.begin(); it != s.end(); it ++)
-	ostr << (it != s.begin() ? "," : "") << *it;
-
-    ostr << "}";
-    return ostr;
+    s1 &= s2;
 }
 
 # endif /* DATAFLOW_H */
@@ -0,0 +1,177 @@
+/*
+ * File:	defuse.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		the def-use index of a function.
+ */
+
+# include <cassert>
+# include <algorithm>
+# include "flowgraph.h"
+# include "defuse.h"
+
+using namespace std;
+
+static const Occurrences none;
+
+
+/*
+ * Function:	unlist (private)
+ *
+ * Description:	Remove one occurrence of the given statement from the
+ *		given list.  The order of the list is not preserved.
+ */
+
+static void unlist(Occurrences &list, Statement *stmt)
+{
+    auto it = find(list.begin(), list.end(), stmt);
+
+
+    assert(it != list.end());
+    *it = list.back();
+    list.pop_back();
+}
+
+
+/*
+ * Function:	DefUse::DefUse (constructor)
+ *
+ * Description:	Build the index for the given function from the blocks in
+ *		its flowgraph.
+ */
+
+DefUse::DefUse(Function &function)
+    : _function(function)
+{
+    _blocks.reserve(function.stmts.size());
+    _defs.reserve(function.stmts.size());
+    _uses.reserve(function.stmts.size());
+
+    for (auto block : getBlocks(function))
+	for (auto stmt : *block)
+	    add(stmt, block);
+}
+
+
+/*
+ * Function:	DefUse::add (private)
+ *
+ * Description:	Record the result and operands of the given statement.
+ */
+
+void DefUse::add(Statement *stmt, Block *block)
+{
+    _blocks[stmt] = block;
+
+    if (stmt->result() != nullptr)
+	_defs[stmt->result()].push_back(stmt);
+
+    for (unsigned i = 0; i < stmt->uses(); i ++)
+	_uses[stmt->use(i)].push_back(stmt);
+}
+
+
+/*
+ * Function:	DefUse::remove (private)
+ *
+ * Description:	Forget the result and operands of the given statement.
+ */
+
+void DefUse::remove(Statement *stmt)
+{
+    _blocks.erase(stmt);
+
+    if (stmt->result() != nullptr)
+	unlist(_defs[stmt->result()], stmt);
+
+    for (unsigned i = 0; i < stmt->uses(); i ++)
+	unlist(_uses[stmt->use(i)], stmt);
+}
+
+
+/*
+ * Function:	DefUse::defs (accessor)
+ *
+ * Description:	Return the statements that assign the given symbol.
+ */
+
+const Occurrences &DefUse::defs(Symbol *sym) const
+{
+    auto it = _defs.find(sym);
+    return it != _defs.end() ? it->second : none;
+}
+
+
+/*
+ * Function:	DefUse::uses (accessor)
+ *
+ * Description:	Return the statements that read the given symbol.
+ */
+
+const Occurrences &DefUse::uses(Symbol *sym) const
+{
+    auto it = _uses.find(sym);
+    return it != _uses.end() ? it->second : none;
+}
+
+
+/*
+ * Function:	DefUse::block (accessor)
+ *
+ * Description:	Return the block containing the given statement.
+ */
+
+Block *DefUse::block(Statement *stmt) const
+{
+    auto it = _blocks.find(stmt);
+    return it != _blocks.end() ? it->second : nullptr;
+}
+
+
+/*
+ * Function:	DefUse::insert
+ *
+ * Description:	Insert a statement into the given block before the given
+ *		position and record it.
+ */
+
+void DefUse::insert(Block *block, Statements::iterator pos, Statement *stmt)
+{
+    insertStatement(_function, block, pos, stmt);
+    add(stmt, block);
+}
+
+
+/*
+ * Function:	DefUse::erase
+ *
+ * Description:	Forget the given statement, and then erase and delete it.
+ */
+
+void DefUse::erase(Statement *stmt)
+{
+    Block *block = this->block(stmt);
+
+
+    assert(block != nullptr);
+    remove(stmt);
+    eraseStatement(_function, block, Statements::iterator(stmt));
+}
+
+
+/*
+ * Function:	DefUse::replace
+ *
+ * Description:	Replace the given operand of the given statement with the
+ *		given symbol.
+ */
+
+void DefUse::replace(Statement *stmt, unsigned i, Symbol *sym)
+{
+    Symbol *&operand = stmt->use(i);
+
+
+    unlist(_uses[operand], stmt);
+    operand = sym;
+    _uses[sym].push_back(stmt);
+}
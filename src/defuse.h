@@ -0,0 +1,48 @@
+/*
+ * File:	defuse.h
+ *
+ * Description:	This file contains the class definition for the def-use
+ *		index of a function.  For each symbol, the index records
+ *		the statements that assign it and the statements that
+ *		read it, along with the block of each statement, so that
+ *		a pass can go directly from a definition to its uses, or
+ *		from a use to the definitions that may reach it, without
+ *		scanning the function.  A statement that reads a symbol
+ *		more than once appears once for each operand.
+ *
+ *		The index is kept up to date by making changes through
+ *		it, rather than to the statements directly.  Since the
+ *		statements are not necessarily in SSA form, a symbol may
+ *		have several definitions, and the uses of a definition are
+ *		those of its symbol.
+ */
+
+# ifndef DEFUSE_H
+# define DEFUSE_H
+# include <vector>
+# include <unordered_map>
+# include "Function.h"
+
+typedef std::vector<Statement *> Occurrences;
+
+class DefUse {
+    Function &_function;
+    std::unordered_map<Symbol *, Occurrences> _defs, _uses;
+    std::unordered_map<Statement *, Block *> _blocks;
+
+    void add(Statement *stmt, Block *block);
+    void remove(Statement *stmt);
+
+public:
+    DefUse(Function &function);
+
+    const Occurrences &defs(Symbol *sym) const;
+    const Occurrences &uses(Symbol *sym) const;
+    Block *block(Statement *stmt) const;
+
+    void insert(Block *block, Statements::iterator pos, Statement *stmt);
+    void erase(Statement *stmt);
+    void replace(Statement *stmt, unsigned i, Symbol *sym);
+};
+
+# endif /* DEFUSE_H */
@@ -0,0 +1,184 @@
+/*
+ * File:	emitter.cpp
+ *
+ * Description:	This file contains the member function and variable
+ *		definitions for the emitter.
+ *
+ *		The emitter is a stream buffer that writes directly to a
+ *		file descriptor, so that the output need not go through
+ *		both the buffer of std::cout and that of the C library.
+ *		Text too large for the buffer is written straight through.
+ *		Only the main thread writes to it; functions compiled
+ *		concurrently are generated into buffers of their own.
+ */
+
+# include <cerrno>
+# include <cstring>
+# include <fcntl.h>
+# include <unistd.h>
+# include "emitter.h"
+
+using namespace std;
+
+static const size_t bufferSize = 1 << 20;
+
+Emitter emitter(STDOUT_FILENO, bufferSize);
+ostream output(&emitter);
+
+
+/*
+ * Function:	writeAll (private)
+ *
+ * Description:	Write the given text to the given file descriptor, and
+ *		return whether all of it was written.
+ */
+
+static bool writeAll(int fd, const char *s, size_t n)
+{
+    ssize_t count;
+
+
+    while (n > 0) {
+	count = write(fd, s, n);
+
+	if (count < 0) {
+	    if (errno == EINTR)
+		continue;
+
+	    return false;
+	}
+
+	s += count;
+	n -= count;
+    }
+
+    return true;
+}
+
+
+/*
+ * Function:	Emitter::Emitter (constructor)
+ *
+ * Description:	Initialize an emitter that writes to the given file
+ *		descriptor using a buffer of the given size.
+ */
+
+Emitter::Emitter(int fd, size_t size)
+    : _fd(fd), _buffer(size)
+{
+    setp(_buffer.data(), _buffer.data() + _buffer.size());
+}
+
+
+/*
+ * Function:	Emitter::~Emitter (destructor)
+ *
+ * Description:	Write out anything left in the buffer and close the file.
+ */
+
+Emitter::~Emitter()
+{
+    drain();
+
+    if (_fd != STDOUT_FILENO)
+	close(_fd);
+}
+
+
+/*
+ * Function:	Emitter::open
+ *
+ * Description:	Write to the file with the given name from now on, and
+ *		return whether it could be created.
+ */
+
+bool Emitter::open(const string &path)
+{
+    int fd;
+
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    if (fd < 0 || !drain())
+	return false;
+
+    if (_fd != STDOUT_FILENO)
+	close(_fd);
+
+    _fd = fd;
+    return true;
+}
+
+
+/*
+ * Function:	Emitter::drain (private)
+ *
+ * Description:	Write out the contents of the buffer and empty it, and
+ *		return whether they were written.
+ */
+
+bool Emitter::drain()
+{
+    if (!writeAll(_fd, pbase(), pptr() - pbase()))
+	return false;
+
+    setp(_buffer.data(), _buffer.data() + _buffer.size());
+    return true;
+}
+
+
+/*
+ * Function:	Emitter::overflow (protected)
+ *
+ * Description:	Empty the full buffer and then add the given character.
+ */
+
+Emitter::int_type Emitter::overflow(int_type c)
+{
+    if (!drain())
+	return traits_type::eof();
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+	*pptr() = traits_type::to_char_type(c);
+	pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+}
+
+
+/*
+ * Function:	Emitter::xsputn (protected)
+ *
+ * Description:	Add the given text to the buffer, emptying it first if the
+ *		text does not fit.  Text at least as large as the buffer is
+ *		written directly.
+ */
+
+streamsize Emitter::xsputn(const char *s, streamsize n)
+{
+    if (n > epptr() - pptr()) {
+	if (!drain())
+	    return 0;
+
+	if ((size_t) n >= _buffer.size())
+	    return writeAll(_fd, s, n) ? n : 0;
+    }
+
+    memcpy(pptr(), s, n);
+    pbump(n);
+    return n;
+}
+
+
+/*
+ * Function:	Emitter::sync (protected)
+ *
+ * Description:	Write out the contents of the buffer when the stream is
+ *		flushed.
+ */
+
+int Emitter::sync()
+{
+    return drain() ? 0 : -1;
+}
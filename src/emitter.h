@@ -0,0 +1,43 @@
+/*
+ * File:	emitter.h
+ *
+ * Description:	This file contains the class definition and public
+ *		variable declarations for the emitter, which collects the
+ *		output of the compiler in a large buffer and writes it to
+ *		the standard output or to a file.
+ *
+ *		The buffer is only written when it fills or when the
+ *		output stream is flushed, which the compiler does after
+ *		each function, rather than on every line.  Lines should
+ *		therefore be ended with '\n' and not std::endl.
+ */
+
+# ifndef EMITTER_H
+# define EMITTER_H
+# include <string>
+# include <vector>
+# include <ostream>
+# include <streambuf>
+
+class Emitter : public std::streambuf {
+    int _fd;
+    std::vector<char> _buffer;
+
+    bool drain();
+
+protected:
+    virtual int_type overflow(int_type c);
+    virtual std::streamsize xsputn(const char *s, std::streamsize n);
+    virtual int sync();
+
+public:
+    Emitter(int fd, size_t size);
+    virtual ~Emitter();
+
+    bool open(const std::string &path);
+};
+
+extern Emitter emitter;
+extern std::ostream output;
+
+# endif /* EMITTER_H */
@@ -3,9 +3,17 @@
  *
  * Description:	This file contains the function definitions for
  *		constructing and optimizing the control-flow graph.
+ *
+ *		Rebuilding the flowgraph from scratch is only necessary
+ *		when labels are created or removed.  Since each block is
+ *		delimited by labels, and a branch, jump, or return always
+ *		ends a block, statements may otherwise be inserted,
+ *		erased, or replaced using the functions at the end of this
+ *		file, which patch the edges of the affected block.
  */
 
 # include <cassert>
+# include <algorithm>
 # include <unordered_map>
 # include <unordered_set>
 # include "flowgraph.h"
@@ -55,7 +63,7 @@ static void mergeAdjacentLabels(Statements &stmts)
 
     for (auto it = stmts.begin(); it != stmts.end(); it ++)
 	if ((*it)->target() != nullptr || !(*it)->fallsThru())
-	    if (!(*next(it))->asLabel())
+	    if (next(it) == stmts.end() || !(*next(it))->asLabel())
 		stmts.insert(next(it), new Label());
 
 
@@ -134,7 +142,7 @@ static bool eliminateMultipleJumps(Statements &stmts)
     auto it = stmts.begin();
 
     while (it != stmts.end())
-	if ((*it)->target() == *next(it)) {
+	if (next(it) != stmts.end() && (*it)->target() == *next(it)) {
 	    it = stmts.erase(it);
 	    changed = true;
 	} else
@@ -193,6 +201,40 @@ bool removeUnneededLabels(Statements &stmts)
 }
 
 
+/*
+ * Function:	linkBlock (private)
+ *
+ * Description:	Link a block to its successors, which are determined by
+ *		its last statement.  If control falls through, the next
+ *		block is a successor.  If the statement has a target, its
+ *		block is a successor.  Otherwise, if control does not fall
+ *		through, the statement is a return and the exit block is
+ *		the successor.
+ */
+
+static void linkBlock(Function &function, Block *block)
+{
+    Label *target;
+    Statement *prevstmt;
+
+
+    prevstmt = *prev(block->_last);
+    target = prevstmt->target();
+
+    if (prevstmt->fallsThru())
+	block->link(block->_next);
+
+    if (target != nullptr) {
+	if (target->_block == nullptr)
+	    target->_block = new Block();
+
+	block->link(target->_block);
+
+    } else if (!prevstmt->fallsThru())
+	block->link(function.exit);
+}
+
+
 /*
  * Function:	buildBasicBlocks (private)
  *
@@ -216,8 +258,7 @@ bool removeUnneededLabels(Statements &stmts)
 static void buildBasicBlocks(Function &function)
 {
     Block *current, *next;
-    Label *label, *target, *exit;
-    Statement *prevstmt;
+    Label *label, *exit;
 
 
     current = nullptr;
@@ -238,27 +279,11 @@ static void buildBasicBlocks(Function &function)
 
 	    if (it != function.stmts.begin()) {
 		current->_last = it;
-		prevstmt = *prev(it);
-		target = prevstmt->target();
-
-		if (prevstmt->fallsThru())
-		    current->link(next);
-
-		if (target != nullptr) {
-		    if (target->_block == nullptr)
-			target->_block = new Block();
-
-		    current->link(target->_block);
-
-		} else if (!prevstmt->fallsThru())
-		    current->link(exit->_block);
-
+		current->_next = next;
+		linkBlock(function, current);
 	    } else
 		function.entry = next;
 
-	    if (current != nullptr)
-		current->_next = next;
-
 	    current = next;
 	}
 
@@ -276,6 +301,7 @@ void rebuildFlowgraph(Function &function)
 {
     bool changed;
 
+    function.stats.rebuilds ++;
     deleteBasicBlocks(function.stmts);
 
     do {
@@ -312,3 +338,300 @@ Blocks getBlocks(Function &function)
 
     return blocks;
 }
+
+
+/*
+ * Function:	reversePostorder
+ *
+ * Description:	Return the blocks in the control-flow graph in reverse
+ *		postorder of a depth-first traversal from the entry block,
+ *		so that each block appears before its successors except
+ *		along back edges.  Any unreachable blocks follow in their
+ *		sequential order.  Reversing the result gives a postorder,
+ *		which is the preferred order for backward problems.
+ */
+
+Blocks reversePostorder(Function &function)
+{
+    Blocks blocks, order;
+    unordered_set<Block *> visited;
+    vector<pair<Block *, unsigned>> stack;
+
+
+    blocks = getBlocks(function);
+    stack.push_back(make_pair(function.entry, 0));
+    visited.insert(function.entry);
+
+    while (!stack.empty()) {
+	Block *block = stack.back().first;
+	unsigned &i = stack.back().second;
+
+	if (i < block->successors().size()) {
+	    Block *succ = block->successors()[i ++];
+
+	    if (visited.insert(succ).second)
+		stack.push_back(make_pair(succ, 0));
+
+	} else {
+	    order.push_back(block);
+	    stack.pop_back();
+	}
+    }
+
+    reverse(order.begin(), order.end());
+
+    for (auto block : blocks)
+	if (visited.count(block) == 0)
+	    order.push_back(block);
+
+    return order;
+}
+
+
+/*
+ * Function:	computeDominators
+ *
+ * Description:	Compute the immediate dominator of each block reachable
+ *		from the entry block, using the iterative algorithm of
+ *		Cooper, Harvey, and Kennedy, and record the resulting
+ *		dominator tree in the blocks.  The entry block and any
+ *		unreachable blocks have no immediate dominator.
+ */
+
+void computeDominators(Function &function)
+{
+    bool changed;
+    Blocks order;
+    unordered_map<Block *, Block *> idom;
+    unordered_map<Block *, unsigned> position;
+
+
+    order = reversePostorder(function);
+
+    for (unsigned i = 0; i < order.size(); i ++) {
+	order[i]->_idom = nullptr;
+	order[i]->_dominated.clear();
+	position[order[i]] = i;
+    }
+
+    idom[function.entry] = function.entry;
+
+    do {
+	changed = false;
+
+	for (auto block : order) {
+	    Block *dom = nullptr;
+
+	    if (block == function.entry)
+		continue;
+
+	    for (auto pred : block->predecessors()) {
+		if (idom.count(pred) == 0)
+		    continue;
+
+		if (dom == nullptr) {
+		    dom = pred;
+		    continue;
+		}
+
+		Block *other = pred;
+
+		while (other != dom) {
+		    while (position[other] > position[dom])
+			other = idom[other];
+
+		    while (position[dom] > position[other])
+			dom = idom[dom];
+		}
+	    }
+
+	    if (dom != nullptr) {
+		auto it = idom.find(block);
+
+		if (it == idom.end() || it->second != dom) {
+		    idom[block] = dom;
+		    changed = true;
+		}
+	    }
+	}
+    } while (changed);
+
+    for (auto block : order)
+	if (block != function.entry && idom.count(block) > 0) {
+	    block->_idom = idom[block];
+	    block->_idom->_dominated.push_back(block);
+	}
+}
+
+
+/*
+ * Function:	dominates
+ *
+ * Description:	Return whether the first block dominates the second, in
+ *		which case every path from the entry block to the second
+ *		block passes through the first.  A block dominates itself.
+ */
+
+bool dominates(Block *block1, Block *block2)
+{
+    while (block2 != nullptr && block2 != block1)
+	block2 = block2->_idom;
+
+    return block2 != nullptr;
+}
+
+
+/*
+ * Function:	computeFrontiers
+ *
+ * Description:	Compute the dominance frontier of each block reachable from
+ *		the entry block, which consists of the blocks where its
+ *		dominance ends: those that it does not strictly dominate
+ *		but that have a predecessor it does dominate.  Following
+ *		Cooper, Harvey, and Kennedy, we walk up the dominator tree
+ *		from each predecessor of a join point until reaching the
+ *		immediate dominator of the join point.  The dominators
+ *		must have already been computed.
+ */
+
+void computeFrontiers(Function &function)
+{
+    Block *runner;
+    Blocks blocks;
+
+
+    blocks = getBlocks(function);
+
+    for (auto block : blocks)
+	block->_frontier.clear();
+
+    for (auto block : blocks) {
+	if (block->predecessors().size() < 2)
+	    continue;
+
+	if (block != function.entry && block->idom() == nullptr)
+	    continue;
+
+	for (auto pred : block->predecessors()) {
+	    if (pred != function.entry && pred->idom() == nullptr)
+		continue;
+
+	    runner = pred;
+
+	    while (runner != nullptr && runner != block->idom()) {
+		Blocks &frontier = runner->_frontier;
+
+		if (find(frontier.begin(), frontier.end(), block) ==
+			frontier.end())
+		    frontier.push_back(block);
+
+		runner = runner->idom();
+	    }
+	}
+    }
+}
+
+
+/*
+ * Function:	isControl (private)
+ *
+ * Description:	Return whether the given statement transfers control, and
+ *		therefore determines the successors of its block.
+ */
+
+static bool isControl(Statement *stmt)
+{
+    return stmt->target() != nullptr || !stmt->fallsThru();
+}
+
+
+/*
+ * Function:	updateBlock
+ *
+ * Description:	Relink the given block to its successors after its last
+ *		statement has changed.
+ */
+
+void updateBlock(Function &function, Block *block)
+{
+    if (block == function.exit)
+	return;
+
+    while (!block->_successors.empty())
+	block->unlink(block->_successors.back());
+
+    linkBlock(function, block);
+}
+
+
+/*
+ * Function:	insertStatement
+ *
+ * Description:	Insert a statement into the given block before the given
+ *		position and return its position.  Only the last statement
+ *		of a block may transfer control, and labels may not be
+ *		inserted since they would require a new block.
+ */
+
+Statements::iterator insertStatement(Function &function, Block *block,
+	Statements::iterator pos, Statement *stmt)
+{
+    assert(stmt->asLabel() == nullptr);
+    assert(!isControl(stmt) || pos == block->end());
+
+    pos = function.stmts.insert(pos, stmt);
+
+    if (isControl(stmt))
+	updateBlock(function, block);
+
+    return pos;
+}
+
+
+/*
+ * Function:	eraseStatement
+ *
+ * Description:	Erase and delete the statement at the given position in the
+ *		given block and return the position of the next statement.
+ */
+
+Statements::iterator eraseStatement(Function &function, Block *block,
+	Statements::iterator pos)
+{
+    Statement *stmt = *pos;
+
+    assert(stmt->asLabel() == nullptr);
+    pos = function.stmts.erase(pos);
+
+    if (isControl(stmt))
+	updateBlock(function, block);
+
+    delete stmt;
+    return pos;
+}
+
+
+/*
+ * Function:	replaceStatement
+ *
+ * Description:	Replace the statement at the given position in the given
+ *		block with another statement, delete the original, and
+ *		return the position of the new statement.
+ */
+
+Statements::iterator replaceStatement(Function &function, Block *block,
+	Statements::iterator pos, Statement *stmt)
+{
+    Statement *old = *pos;
+
+    assert(stmt->asLabel() == nullptr);
+    assert(!isControl(stmt) || next(pos) == block->end());
+
+    pos = function.stmts.replace(pos, stmt);
+
+    if (isControl(old) || isControl(stmt))
+	updateBlock(function, block);
+
+    delete old;
+    return pos;
+}
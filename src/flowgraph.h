@@ -11,5 +11,18 @@
 
 void rebuildFlowgraph(Function &function);
 Blocks getBlocks(Function &function);
+Blocks reversePostorder(Function &function);
+
+void computeDominators(Function &function);
+bool dominates(Block *block1, Block *block2);
+void computeFrontiers(Function &function);
+
+void updateBlock(Function &function, Block *block);
+Statements::iterator insertStatement(Function &function, Block *block,
+	Statements::iterator pos, Statement *stmt);
+Statements::iterator eraseStatement(Function &function, Block *block,
+	Statements::iterator pos);
+Statements::iterator replaceStatement(Function &function, Block *block,
+	Statements::iterator pos, Statement *stmt);
 
 # endif /* FLOWGRAPH_H */
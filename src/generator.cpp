@@ -4,17 +4,41 @@
  * Description:	This file contains the public and private function and
  *		variable definitions for the code generator for Tiny C.
  *
- *		The register allocator is very simple.
+ *		Register allocation happens at two levels.  First, a linear
+ *		scan over the live intervals of the local variables and
+ *		temporaries that are live across blocks gives some of them
+ *		a home in one of the callee-saved registers for the entire
+ *		function, in place of their location on the stack.  When
+ *		all of them are taken, the interval that ends furthest away
+ *		is left on the stack.  The registers used are saved in the
+ *		prologue and restored in the epilogue.
  *
- *		It assumes that a source operand is either never used again
- *		or can be reread from memory, and therefore its register
- *		can be used for the result or deallocated after use.
+ *		Second, within each block, the caller-saved registers are
+ *		allocated using next-use information.  A value is kept in
+ *		its register as long as it is used again in the block, and
+ *		is only written back to its home if it is live on exit from
+ *		the block and not assigned again.  When no register is
+ *		free, the one whose value is used furthest in the future
+ *		is spilled.  At the end of each block, every value that is
+ *		live on exit is in its home, so the registers are simply
+ *		forgotten.
  *
  *		It does not take into account commutativity or duality of
  *		binary operators.
+ *
+ *		On x86-64, values of type int are still computed using the
+ *		32-bit register names, and only addresses use the full
+ *		registers.  An int used as an array index is therefore
+ *		sign-extended in place before being added to an address,
+ *		which is harmless since no 32-bit instruction reads the
+ *		upper half of a register.  The first six arguments of a
+ *		call are passed in registers, and the callee stores them to
+ *		their own locations in its prologue.
  */
 
 # include <cassert>
+# include <climits>
+# include <sstream>
 # include <iostream>
 # include <algorithm>
 # include <unordered_map>
@@ -22,16 +46,16 @@
 # include "machine.h"
 # include "Register.h"
 # include "flowgraph.h"
+# include "optimizer.h"
 # include "generator.h"
+# include "emitter.h"
+# include "peephole.h"
+# include "opflgs.h"
 
 using namespace std;
 
 # define isVariable(s) ((s)->kind() == LOCAL || (s)->kind() == GLOBAL)
 
-# define nextuse(s) false
-# define nextdef(s) false
-# define liveonexit(s) (isVariable(s))
-
 # define shrink_pool(pool,reg) \
     pool.erase(remove(pool.begin(), pool.end(), reg), pool.end())
 
@@ -47,44 +71,66 @@ using namespace std;
 # define isImmediate(s) \
     ((s)->kind() == NUM || (s)->kind() == STRLIT || isGlobalArray(s))
 
-# define isByteObject(s) \
-    ((s)->type().isScalar() && (s)->type().size() == 1)
+# define isAddress(s) (isLocalArray(s) || \
+    (target64 && ((s)->kind() == STRLIT || isGlobalArray(s))))
 
-//TODO: LRA
+# define width(s) ((s)->type().isArray() ? SIZEOF_PTR : SIZEOF_INT)
 
-bool nextuse1(Symbol *s) {
-	
-	return false;
-}
+# define isByteObject(s) \
+    ((s)->type().isScalar() && (s)->type().size() == 1)
 
-bool nextdef1(Symbol *s) {
-	
-	return false;
-}
+# define isHomed(s) (homes.count(s) > 0)
 
-bool liveonexit1(Symbol *s) {
-	
-	return false;
-}
+# define NONE UINT_MAX
 
 
 /* For code generation */
 
-static unsigned max_args;
-static int offset, param_offset;
+static thread_local unsigned max_args, stack_params;
+static thread_local ostringstream code;
+static thread_local int offset, param_offset, saves;
+static thread_local Label *return_label;
 static unordered_map<Symbol *, int> strings;
-static Label *return_label;
 
 
-/* The registers */
+/* The registers, which are per thread so that functions can be generated
+   concurrently */
+
+static thread_local Register *eax = new Register("%eax", "%al", "%rax");
+static thread_local Register *ecx = new Register("%ecx", "%cl", "%rcx");
+static thread_local Register *edx = new Register("%edx", "%dl", "%rdx");
+static thread_local Register *ebx = new Register("%ebx", "%bl", "%rbx");
+static thread_local Register *esi = new Register("%esi");
+static thread_local Register *edi = new Register("%edi");
 
-static Register *eax = new Register("%eax", "%al");
-static Register *ecx = new Register("%ecx", "%cl");
-static Register *edx = new Register("%edx", "%dl");
+static thread_local Register *rsi = new Register("%esi", "%sil", "%rsi");
+static thread_local Register *rdi = new Register("%edi", "%dil", "%rdi");
+static thread_local Register *r8 = new Register("%r8d", "%r8b", "%r8");
+static thread_local Register *r9 = new Register("%r9d", "%r9b", "%r9");
+static thread_local Register *r10 = new Register("%r10d", "%r10b", "%r10");
+static thread_local Register *r11 = new Register("%r11d", "%r11b", "%r11");
+static thread_local Register *r12 = new Register("%r12d", "%r12b", "%r12");
+static thread_local Register *r13 = new Register("%r13d", "%r13b", "%r13");
+static thread_local Register *r14 = new Register("%r14d", "%r14b", "%r14");
+static thread_local Register *r15 = new Register("%r15d", "%r15b", "%r15");
 
 typedef vector <Register *> Registers;
-static Registers caller_saved = {eax, ecx, edx};
-static Registers registers = caller_saved;
+static thread_local Registers caller_saved, callee_saved, registers, saved;
+static thread_local Registers parameters = {rdi, rsi, edx, ecx, r8, r9};
+
+
+/* For register allocation */
+
+struct Uses {
+    vector<unsigned> uses, defs;
+};
+
+static thread_local Block *current_block;
+static thread_local unsigned position;
+static thread_local unordered_map<Symbol *, Uses> next_uses;
+static thread_local vector<unsigned> calls;
+static thread_local unordered_map<Symbol *, Register *> homes;
+static thread_local unordered_map<Symbol *, Register *> shared;
 
 
 /* Data transfer primitives */
@@ -114,6 +160,284 @@ static void deallocate(Register *reg);
 static Register *allocate(Registers &pool = registers);
 
 
+/*
+ * Function:	regof (private)
+ *
+ * Description:	Return a reference to the register holding the given
+ *		symbol.  Local variables and temporaries belong to the
+ *		function being generated and so record their register
+ *		themselves, but globals and literals are shared by all
+ *		functions and so are recorded separately for each thread.
+ */
+
+static Register *&regof(Symbol *sym)
+{
+    if (sym->kind() == LOCAL || sym->kind() == TEMP)
+	return sym->_register;
+
+    return shared[sym];
+}
+
+
+/*
+ * Function:	following (private)
+ *
+ * Description:	Return the first position in the given sorted list that
+ *		is at or after the given position, or NONE if there is
+ *		none.
+ */
+
+static unsigned following(const vector<unsigned> &positions, unsigned from)
+{
+    auto it = lower_bound(positions.begin(), positions.end(), from);
+    return it != positions.end() ? *it : NONE;
+}
+
+
+/*
+ * Function:	nextuseat (private)
+ *
+ * Description:	Return the position in the current block, starting from
+ *		the given position, at which the current value of the
+ *		given symbol is next used, or NONE if it is not used again
+ *		before the end of the block or before being assigned again.
+ *		A call uses every global variable.  A symbol being assigned
+ *		by the current statement is considered to be in use.
+ */
+
+static unsigned nextuseat(Symbol *sym, unsigned from)
+{
+    unsigned use, def;
+    auto it = next_uses.find(sym);
+
+
+    use = def = NONE;
+
+    if (it != next_uses.end()) {
+	use = following(it->second.uses, from);
+	def = following(it->second.defs, from);
+    }
+
+    if (sym->kind() == GLOBAL) {
+	auto call = lower_bound(calls.begin(), calls.end(), from);
+
+	if (call != calls.end())
+	    use = min(use, *call);
+    }
+
+    if (def == position)
+	return position;
+
+    return use <= def ? use : NONE;
+}
+
+
+/*
+ * Function:	nextuse (private)
+ *
+ * Description:	Return whether the current value of the given symbol is
+ *		used again in the current block.
+ */
+
+static bool nextuse(Symbol *sym)
+{
+    return nextuseat(sym, position + 1) != NONE;
+}
+
+
+/*
+ * Function:	nextdef (private)
+ *
+ * Description:	Return whether the given symbol is assigned again in the
+ *		current block.
+ */
+
+static bool nextdef(Symbol *sym)
+{
+    auto it = next_uses.find(sym);
+    return it != next_uses.end() &&
+	following(it->second.defs, position + 1) != NONE;
+}
+
+
+/*
+ * Function:	liveonexit (private)
+ *
+ * Description:	Return whether the given symbol is live on exit from the
+ *		current block.  A global variable is always considered to
+ *		be live, since it may be used by another function.
+ */
+
+static bool liveonexit(Symbol *sym)
+{
+    return sym->kind() == GLOBAL || isLiveOut(current_block, sym);
+}
+
+
+/*
+ * Function:	computeNextUses (private)
+ *
+ * Description:	Record the positions at which each symbol is used and
+ *		assigned in the given block, along with the positions of
+ *		any calls, for computing next-use information.  Position
+ *		zero is the label of the block.
+ */
+
+static void computeNextUses(Block *block)
+{
+    unsigned pos;
+
+
+    current_block = block;
+    next_uses.clear();
+    calls.clear();
+    pos = 0;
+
+    for (auto it = block->first(); it != block->last(); it ++, pos ++) {
+	Statement *stmt = *it;
+
+	for (unsigned i = 0; i < stmt->uses(); i ++)
+	    if (!isLiteral(stmt->use(i)))
+		next_uses[stmt->use(i)].uses.push_back(pos);
+
+	if (stmt->result() != nullptr)
+	    next_uses[stmt->result()].defs.push_back(pos);
+
+	if (dynamic_cast<Call *>(stmt) != nullptr)
+	    calls.push_back(pos);
+    }
+}
+
+
+/*
+ * Function:	allocateHomes (private)
+ *
+ * Description:	Give each local variable or temporary that is live across
+ *		blocks a home in a callee-saved register if possible, using
+ *		linear scan over live intervals.  The statements are
+ *		numbered in order, and the interval of a symbol extends
+ *		from its first to its last appearance, and over any block
+ *		on whose entry or exit it is live.  Liveness must have
+ *		already been computed.
+ */
+
+static void allocateHomes(const Blocks &blocks)
+{
+    unsigned pos, start;
+    Symbols candidates, active;
+    unordered_map<Symbol *, pair<unsigned, unsigned>> intervals;
+
+    auto extend = [&](Symbol *sym, unsigned pos) {
+	auto it = intervals.find(sym);
+
+	if (it == intervals.end())
+	    intervals.emplace(sym, make_pair(pos, pos));
+	else {
+	    it->second.first = min(it->second.first, pos);
+	    it->second.second = max(it->second.second, pos);
+	}
+    };
+
+    auto eligible = [](Symbol *sym) {
+	return (sym->kind() == LOCAL || sym->kind() == TEMP) &&
+	    sym->type().isScalar() && !isByteObject(sym);
+    };
+
+
+    /* Only symbols live across blocks need a home. */
+
+    homes.clear();
+    pos = 0;
+
+    for (auto block : blocks) {
+	start = pos;
+
+	for (auto it = block->begin(); it != block->end(); it ++)
+	    pos ++;
+
+	for (auto sym : liveIn(block))
+	    if (eligible(sym)) {
+		if (intervals.count(sym) == 0)
+		    candidates.push_back(sym);
+
+		extend(sym, start);
+	    }
+
+	for (auto sym : liveOut(block))
+	    if (eligible(sym)) {
+		if (intervals.count(sym) == 0)
+		    candidates.push_back(sym);
+
+		extend(sym, pos);
+	    }
+    }
+
+
+    /* Extend the intervals to cover every use and assignment. */
+
+    pos = 0;
+
+    for (auto block : blocks)
+	for (auto it = block->begin(); it != block->end(); it ++, pos ++) {
+	    Statement *stmt = *it;
+
+	    for (unsigned i = 0; i < stmt->uses(); i ++)
+		if (intervals.count(stmt->use(i)) > 0)
+		    extend(stmt->use(i), pos);
+
+	    if (stmt->result() != nullptr && intervals.count(stmt->result()) > 0)
+		extend(stmt->result(), pos);
+	}
+
+
+    /* Scan the intervals in order of their starting positions. */
+
+    stable_sort(candidates.begin(), candidates.end(),
+	[&](Symbol *a, Symbol *b) {
+	    return intervals[a].first < intervals[b].first;
+	});
+
+    for (auto sym : candidates) {
+	Register *reg = nullptr;
+	Symbol *victim = nullptr;
+
+	for (unsigned i = 0; i < active.size(); )
+	    if (intervals[active[i]].second < intervals[sym].first)
+		active.erase(active.begin() + i);
+	    else
+		i ++;
+
+	for (auto saved : callee_saved) {
+	    reg = saved;
+
+	    for (auto other : active)
+		if (homes[other] == saved)
+		    reg = nullptr;
+
+	    if (reg != nullptr)
+		break;
+	}
+
+	if (reg == nullptr) {
+	    for (auto other : active)
+		if (victim == nullptr ||
+		    intervals[other].second > intervals[victim].second)
+		    victim = other;
+
+	    if (intervals[victim].second <= intervals[sym].second)
+		continue;
+
+	    reg = homes[victim];
+	    homes.erase(victim);
+	    active.erase(find(active.begin(), active.end(), victim));
+	}
+
+	homes[sym] = reg;
+	active.push_back(sym);
+    }
+}
+
+
 /*
  * Function:	align (private)
  *
@@ -142,37 +466,85 @@ static unsigned basesize(const Symbol *sym)
 }
 
 
+/*
+ * Function:	suffix (private)
+ *
+ * Description:	Return the instruction suffix for the given access size.
+ */
+
+static string suffix(unsigned size)
+{
+    if (size == 1)
+	return "b";
+
+    return size == 8 ? "q" : "l";
+}
+
+
+/*
+ * Function:	number (private)
+ *
+ * Description:	Return the number of the given string literal, numbering
+ *		it if it has not yet been seen.
+ */
+
+static unsigned number(Symbol *sym)
+{
+    auto it = strings.find(sym);
+    unsigned n = strings.size();
+
+
+    if (it != strings.end())
+	return it->second;
+
+    strings[sym] = n;
+    return n;
+}
+
+
 /*
  * Function:	operand (private)
  *
  * Description:	Return a string operand designating the memory location of
- *		the given operand.
+ *		the given operand, or its home register if it has one.  On
+ *		x86-64, a global or string literal is addressed relative to
+ *		the instruction pointer, and so its address is never an
+ *		immediate value.
  */
 
 static string operand(Symbol *sym)
 {
+    string name;
+
+
     if (sym->kind() == NUM)
 	return "$" + sym->name();
 
-    if (sym->kind() == GLOBAL && sym->type().isArray())
-	return "$" + string(global_prefix) + sym->name();
-
     if (sym->kind() == GLOBAL)
-	return global_prefix + sym->name();
+	name = global_prefix + sym->name();
+
+    else if (sym->kind() == STRLIT)
+	name = string_prefix + to_string(number(sym));
 
-    if (sym->kind() == STRLIT) {
-	if (strings.count(sym) == 0)
-	    strings[sym] = strings.size();
+    if (!name.empty()) {
+	if (target64)
+	    return name + "(%rip)";
 
-	return "$" + string(string_prefix) + to_string(strings[sym]);
+	if (sym->type().isArray())
+	    return "$" + name;
+
+	return name;
     }
 
     assert(sym->kind() == LOCAL || sym->kind() == TEMP);
 
+    if (isHomed(sym))
+	return homes[sym]->name();
+
     if (sym->_offset == 0)
 	sym->_offset = offset -= sym->type().size();
 
-    return to_string(sym->_offset) + "(%ebp)";
+    return to_string(sym->_offset) + "(" + frame_pointer + ")";
 }
 
 
@@ -186,8 +558,8 @@ static string operand(Symbol *sym)
 
 static ostream &operator <<(ostream &ostr, Symbol *symbol)
 {
-    if (symbol->_register != nullptr)
-	return ostr << symbol->_register;
+    if (regof(symbol) != nullptr)
+	return ostr << regof(symbol)->name(width(symbol));
 
     return ostr << operand(symbol);
 }
@@ -203,15 +575,15 @@ static ostream &operator <<(ostream &ostr, Symbol *symbol)
 static void assign(Symbol *symbol, Register *reg)
 {
     if (symbol != nullptr) {
-	if (symbol->_register != nullptr)
-	    symbol->_register->_symbol = nullptr;
+	if (regof(symbol) != nullptr)
+	    regof(symbol)->_symbol = nullptr;
 
-	symbol->_register = reg;
+	regof(symbol) = reg;
     }
 
     if (reg != nullptr) {
 	if (reg->_symbol != nullptr)
-	    reg->_symbol->_register = nullptr;
+	    regof(reg->_symbol) = nullptr;
 
 	reg->_symbol = symbol;
     }
@@ -229,7 +601,8 @@ static void assign(Symbol *symbol, Register *reg)
 static void move(const Register *src, const Register *dst)
 {
     assert(src != nullptr && dst != nullptr);
-    cout << "\tmovl\t" << src << ", " << dst << endl;
+    code << "\tmov" << suffix(SIZEOF_REG) << "\t" << src->name(SIZEOF_REG);
+    code << ", " << dst->name(SIZEOF_REG) << '\n';
 }
 
 
@@ -245,12 +618,15 @@ static void load(Symbol *sym, const Register *reg)
 {
     assert(sym != nullptr && reg != nullptr);
 
-    if (isLocalArray(sym))
-	cout << "\tleal\t" << operand(sym) << ", " << reg << endl;
-    else if (isByteObject(sym))
-	cout << "\tmovsbl\t" << operand(sym) << ", " << reg << endl;
-    else
-	cout << "\tmovl\t" << operand(sym) << ", " << reg << endl;
+    if (isAddress(sym)) {
+	code << "\tlea" << suffix(SIZEOF_PTR) << "\t" << operand(sym) << ", ";
+	code << reg->name(SIZEOF_PTR) << '\n';
+    } else if (isByteObject(sym))
+	code << "\tmovsbl\t" << operand(sym) << ", " << reg << '\n';
+    else {
+	code << "\tmov" << suffix(width(sym)) << "\t" << operand(sym) << ", ";
+	code << reg->name(width(sym)) << '\n';
+    }
 }
 
 
@@ -266,9 +642,11 @@ static void store(const Register *reg, Symbol *sym)
     assert(reg != nullptr && sym != nullptr);
 
     if (isByteObject(sym))
-	cout << "\tmovb\t" << reg->byte() << ", " << operand(sym) << endl;
-    else
-	cout << "\tmovl\t" << reg->name() << ", " << operand(sym) << endl;
+	code << "\tmovb\t" << reg->byte() << ", " << operand(sym) << '\n';
+    else {
+	code << "\tmov" << suffix(width(sym)) << "\t" << reg->name(width(sym));
+	code << ", " << operand(sym) << '\n';
+    }
 }
 
 
@@ -285,9 +663,9 @@ static void store(int imm, Symbol *sym)
     assert(sym != nullptr);
 
     if (sym->type().size() == 1)
-	cout << "\tmovb\t$" << (char) imm << ", " << operand(sym) << endl;
+	code << "\tmovb\t$" << (int) (char) imm << ", " << operand(sym) << '\n';
     else
-	cout << "\tmovl\t$" << imm << ", " << operand(sym) << endl;
+	code << "\tmovl\t$" << imm << ", " << operand(sym) << '\n';
 }
 
 
@@ -305,9 +683,9 @@ static void iload(const Register *src, const Register *dst, unsigned size)
     assert(src != nullptr && dst != nullptr && (size == 1 || size == 4));
 
     if (size == 1)
-	cout << "\tmovsbl\t(" << src << "), " << dst << endl;
+	code << "\tmovsbl\t(" << src->name(SIZEOF_PTR) << "), " << dst << '\n';
     else
-	cout << "\tmovl\t(" << src << "), " << dst << endl;
+	code << "\tmovl\t(" << src->name(SIZEOF_PTR) << "), " << dst << '\n';
 }
 
 
@@ -323,10 +701,13 @@ static void istore(const Register *src, const Register *dst, unsigned size)
 {
     assert(src != nullptr && dst != nullptr && (size == 1 || size == 4));
 
-    if (size == 1)
-	cout << "\tmovb\t" << src->byte() << ", (" << dst << ")" << endl;
-    else
-	cout << "\tmovl\t" << src->name() << ", (" << dst << ")" << endl;
+    if (size == 1) {
+	code << "\tmovb\t" << src->byte() << ", (";
+	code << dst->name(SIZEOF_PTR) << ")" << '\n';
+    } else {
+	code << "\tmovl\t" << src->name() << ", (";
+	code << dst->name(SIZEOF_PTR) << ")" << '\n';
+    }
 }
 
 
@@ -342,10 +723,13 @@ static void istore(int imm, const Register *dst, unsigned size)
 {
     assert(dst != nullptr && (size == 1 || size == 4));
 
-    if (size == 1)
-	cout << "\tmovb\t$" << (int) (char) imm << ", (" << dst << ")" << endl;
-    else
-	cout << "\tmovl\t$" << imm << ", (" << dst << ")" << endl;
+    if (size == 1) {
+	code << "\tmovb\t$" << (int) (char) imm << ", (";
+	code << dst->name(SIZEOF_PTR) << ")" << '\n';
+    } else {
+	code << "\tmovl\t$" << imm << ", (";
+	code << dst->name(SIZEOF_PTR) << ")" << '\n';
+    }
 }
 
 
@@ -360,21 +744,21 @@ static void istore(int imm, const Register *dst, unsigned size)
 static void getreg(Symbol *dst, Symbol *src)
 {
     if (src != dst) {
-	if (src->_register != nullptr && !nextuse(src))
-	    assign(dst, src->_register);
+	if (regof(src) != nullptr && !nextuse(src))
+	    assign(dst, regof(src));
 	else {
-	    auto reg = src->_register;
+	    auto reg = regof(src);
 	    assign(dst, allocate());
 
-	    if (src->_register != nullptr)
-		move(src->_register, dst->_register);
-	    else if (reg != dst->_register)
-		load(src, dst->_register);
+	    if (regof(src) != nullptr)
+		move(regof(src), regof(dst));
+	    else if (reg != regof(dst))
+		load(src, regof(dst));
 	}
 
-    } else if (dst->_register == nullptr) {
+    } else if (regof(dst) == nullptr) {
 	assign(dst, allocate());
-	load(src, dst->_register);
+	load(src, regof(dst));
     }
 }
 
@@ -391,9 +775,9 @@ static void load(Symbol *sym, Registers &pool)
 {
     assert(sym != nullptr);
 
-    if (sym->_register == nullptr) {
+    if (regof(sym) == nullptr) {
 	assign(sym, allocate(pool));
-	load(sym, sym->_register);
+	load(sym, regof(sym));
     }
 }
 
@@ -401,15 +785,17 @@ static void load(Symbol *sym, Registers &pool)
 /*
  * Function:	spill (private)
  *
- * Description:	Convenience function to store a register to memory and then
- *		deallocate the register.  The register mappings ARE
- *		updated.
+ * Description:	Convenience function to store a register to memory if it
+ *		has been modified and then deallocate the register.  The
+ *		register mappings ARE updated.
  */
 
 static void spill(Register *reg)
 {
     if (reg->_symbol != nullptr) {
-	store(reg, reg->_symbol);
+	if (reg->_dirty)
+	    store(reg, reg->_symbol);
+
 	deallocate(reg);
     }
 }
@@ -425,7 +811,7 @@ static void spill(Register *reg)
 void release(Symbol *sym)
 {
     if (!nextuse(sym))
-	deallocate(sym->_register);
+	deallocate(regof(sym));
 }
 
 
@@ -433,16 +819,21 @@ void release(Symbol *sym)
  * Function:	save (private)
  *
  * Description:	Convenience function to store a symbol by writing it back
- *		to memory if necessary.
+ *		to memory if necessary.  A character is always written back
+ *		and reread, so that its value is properly truncated.
  */
 
 void save(Symbol *sym)
 {
-    sym->_register->_dirty = true;
+    regof(sym)->_dirty = true;
+
+    if (isByteObject(sym)) {
+	store(regof(sym), sym);
+	deallocate(regof(sym));
 
-    if (!nextdef(sym) && liveonexit(sym)) {
-	store(sym->_register, sym);
-	sym->_register->_dirty = false;
+    } else if (!nextdef(sym) && liveonexit(sym)) {
+	store(regof(sym), sym);
+	regof(sym)->_dirty = false;
 	release(sym);
     }
 }
@@ -467,21 +858,34 @@ static void deallocate(Register *reg)
  * Function:	allocate (private)
  *
  * Description:	Allocate a register from the given register pool.  If no
- *		register is available, then the first one is spilled.
+ *		register is available, then the one whose value is used
+ *		furthest in the future is spilled.  The operands of the
+ *		current statement are therefore spilled last.
  */
 
 static Register *allocate(Registers &pool)
 {
+    Register *victim;
+    unsigned furthest, next;
+
+
     assert(!pool.empty());
 
     for (auto reg : pool)
 	if (reg->_symbol == nullptr)
 	    return reg;
 
-    spill(pool[0]);
-    assign(nullptr, pool[0]);
+    victim = pool[0];
+    furthest = nextuseat(victim->_symbol, position);
 
-    return pool[0];
+    for (auto reg : pool)
+	if ((next = nextuseat(reg->_symbol, position)) > furthest) {
+	    victim = reg;
+	    furthest = next;
+	}
+
+    spill(victim);
+    return victim;
 }
 
 
@@ -504,7 +908,7 @@ void Null::generate()
 
 void Label::generate()
 {
-    cout << label_prefix << _number << ":" << endl;
+    code << label_prefix << _number << ":" << '\n';
 }
 
 
@@ -516,7 +920,7 @@ void Label::generate()
 
 void Jump::generate()
 {
-    cout << "\tjmp\t" << label_prefix << _target->_number << endl;
+    code << "\tjmp\t" << label_prefix << _target->_number << '\n';
 }
 
 
@@ -534,42 +938,91 @@ void Branch::generate()
     };
 
 
-    load(_left);
+    if (!isHomed(_left))
+	load(_left);
 
-    cout << "\tcmpl\t" << _right << ", " << _left->_register << endl;
-    cout << "\t" << jump_ops[_token] << "\t";
-    cout << label_prefix << _target->_number << endl;
+    code << "\tcmpl\t" << _right << ", " << _left << '\n';
+    code << "\t" << jump_ops.at(_token) << "\t";
+    code << label_prefix << _target->_number << '\n';
 
     release(_left);
     release(_right);
 }
 
 
+/*
+ * Function:	restoreFrame (private)
+ *
+ * Description:	Restore the callee-saved registers and the frame of our
+ *		caller, leaving the return address on top of the stack.
+ */
+
+static void restoreFrame()
+{
+    int slot = saves;
+
+
+    for (auto reg : saved) {
+	slot -= SIZEOF_REG;
+	code << "\tmov" << suffix(SIZEOF_REG) << "\t" << slot << "(";
+	code << frame_pointer << "), " << reg->name(SIZEOF_REG) << '\n';
+    }
+
+    code << "\tmov" << suffix(SIZEOF_REG) << "\t" << frame_pointer << ", ";
+    code << stack_pointer << '\n';
+    code << "\tpop" << suffix(SIZEOF_REG) << "\t" << frame_pointer << '\n';
+}
+
+
 /*
  * Function:	loadArgument (private)
  *
  * Description:	Load an argument onto the stack.  This function is more
  *		complicated than it should be because an argument can be an
  *		array or a string literal, in which case we have to
- *		effectively compute its address here.
+ *		effectively compute its address here.  The argument is not
+ *		released, since it may be passed more than once.
  */
 
 static void loadArgument(Symbol *arg, int offset, const string &base)
 {
-    if (isLocalArray(arg)) {
+    if (isAddress(arg)) {
 	assign(arg, allocate());
-	load(arg, arg->_register);
-	cout << "\tmovl\t" << arg;
+	load(arg, regof(arg));
+	code << "\tmov" << suffix(SIZEOF_PTR) << "\t" << arg;
 
     } else {
-	if (!isImmediate(arg))
+	if (!isImmediate(arg) && !isHomed(arg))
 	    load(arg);
 
-	cout << "\tmovl\t" << arg;
+	code << "\tmov" << suffix(width(arg)) << "\t" << arg;
     }
 
-    cout << ", " << offset << "(" << base << ")" << endl;
-    release(arg);
+    code << ", " << offset << "(" << base << ")" << '\n';
+}
+
+
+/*
+ * Function:	loadParameter (private)
+ *
+ * Description:	Load an argument into the given parameter register.  The
+ *		register is first spilled unless it already holds the
+ *		argument.  No register is allocated, so the arguments
+ *		already loaded into the other parameter registers are not
+ *		disturbed.
+ */
+
+static void loadParameter(Symbol *arg, Register *reg)
+{
+    if (reg->_symbol == arg)
+	return;
+
+    spill(reg);
+
+    if (regof(arg) != nullptr)
+	move(regof(arg), reg);
+    else
+	load(arg, reg);
 }
 
 
@@ -581,20 +1034,61 @@ static void loadArgument(Symbol *arg, int offset, const string &base)
 
 void Call::generate()
 {
-    if (_arguments.size() > max_args)
-	max_args = _arguments.size();
+    unsigned first, count;
+
 
-    for (int i = _arguments.size() - 1; i >= 0; i --)
-	loadArgument(_arguments[i], SIZEOF_ARG * i, "%esp");
+    first = (target64 ? min(_arguments.size(), parameters.size()) : 0);
+    count = _arguments.size() - first;
+
+    if (count > max_args)
+	max_args = count;
+
+    for (int i = _arguments.size() - 1; i >= (int) first; i --)
+	loadArgument(_arguments[i], SIZEOF_ARG * (i - first), stack_pointer);
+
+    for (unsigned i = 0; i < first; i ++)
+	loadParameter(_arguments[i], parameters[i]);
+
+    for (auto arg : _arguments)
+	release(arg);
 
     for (auto reg : caller_saved)
 	spill(reg);
 
-    cout << "\tcall\t" << global_prefix << _function->name() << endl;
 
-    if (_result != nullptr) {
+    /* A tail call whose arguments fit where ours were passed moves
+       them there and jumps to the callee with our caller's frame.
+       Otherwise, it is made as usual and we return its result. */
+
+    if (_tail && count <= stack_params) {
+	for (unsigned i = 0; i < count; i ++) {
+	    code << "\tmov" << suffix(SIZEOF_ARG) << "\t" << SIZEOF_ARG * i;
+	    code << "(" << stack_pointer << "), " << eax->name(SIZEOF_ARG);
+	    code << '\n' << "\tmov" << suffix(SIZEOF_ARG) << "\t";
+	    code << eax->name(SIZEOF_ARG) << ", " << param_offset +
+		SIZEOF_ARG * i << "(" << frame_pointer << ")" << '\n';
+	}
+
+	restoreFrame();
+
+	if (target64)
+	    code << "\tmovl\t$0, %eax" << '\n';
+
+	code << "\tjmp\t" << global_prefix << _function->name() << '\n';
+	return;
+    }
+
+    if (target64)
+	code << "\tmovl\t$0, %eax" << '\n';
+
+    code << "\tcall\t" << global_prefix << _function->name() << '\n';
+
+    if (_tail)
+	code << "\tjmp\t" << label_prefix << return_label->_number << '\n';
+
+    else if (_result != nullptr) {
 	if (basesize(_function) == 1)
-	    cout << "\tmovsbl\t%al, %eax" << endl;
+	    code << "\tmovsbl\t%al, %eax" << '\n';
 
 	assign(_result, eax);
 	save(_result);
@@ -610,12 +1104,12 @@ void Call::generate()
 
 void Return::generate()
 {
-    if (_expr->_register == nullptr)
+    if (regof(_expr) == nullptr)
 	load(_expr, eax);
-    else if (_expr->_register != eax)
-	move(_expr->_register, eax);
+    else if (regof(_expr) != eax)
+	move(regof(_expr), eax);
 
-    cout << "\tjmp\t" << label_prefix << return_label->_number << endl;
+    code << "\tjmp\t" << label_prefix << return_label->_number << '\n';
 
     release(_expr);
     deallocate(eax);
@@ -630,6 +1124,7 @@ void Return::generate()
 
 void Binary::generate()
 {
+    Symbol *right;
     Register *reg;
 
     static unordered_map<int, string> set_ops = {
@@ -638,64 +1133,76 @@ void Binary::generate()
     };
 
 
+    /* If both operands are the same symbol, the arithmetic operators
+       take the right operand from the result, since getreg may have
+       given the only copy of the left operand to the result. */
+
+    right = (_right == _left ? _result : _right);
+
+
     switch(_token) {
     case EQL: case NEQ: case LEQ: case GEQ: case '<': case '>':
 	load(_left);
-	cout << "\tcmpl\t" << _right << ", " << _left << endl;
+	code << "\tcmpl\t" << _right << ", " << _left << '\n';
 	release(_left);
 	release(_right);
 
 	reg = allocate();
 	assign(_result, reg);
-	cout << "\t" << set_ops[_token] << "\t" << reg->byte() << endl;
-	cout << "\tmovzbl\t" << reg->byte() << ", " << reg << endl;
+	code << "\t" << set_ops.at(_token) << "\t" << reg->byte() << '\n';
+	code << "\tmovzbl\t" << reg->byte() << ", " << reg << '\n';
 	break;
 
 
     case '+':
 	getreg(_result, _left);
-	cout << "\taddl\t" << _right << ", " << _result << endl;
+	code << "\taddl\t" << right << ", " << _result << '\n';
 	release(_right);
 	break;
 
 
     case '-':
 	getreg(_result, _left);
-	cout << "\tsubl\t" << _right << ", " << _result << endl;
+	code << "\tsubl\t" << right << ", " << _result << '\n';
 	release(_right);
 	break;
 
 
     case '*':
 	getreg(_result, _left);
-	cout << "\timull\t" << _right << ", " << _result << endl;
+	code << "\timull\t" << right << ", " << _result << '\n';
 	release(_right);
 	break;
 
 
     case '/':
     case '%':
-	if (isNumber(_right) && _right->_register != ecx) {
+	if (isNumber(_right) && regof(_right) != ecx) {
 	    spill(ecx);
 	    assign(_right, ecx);
 	    load(_right, ecx);
 	}
 
-	if (_left->_register == nullptr) {
+	if (regof(_left) == nullptr) {
 	    spill(eax);
 	    load(_left, eax);
-	} else if (_left->_register != eax) {
+	} else if (regof(_left) != eax) {
+	    spill(eax);
+	    move(regof(_left), eax);
+
+	    if (_right != _left)
+		release(_left);
+
+	} else if (nextuse(_left))
 	    spill(eax);
-	    move(_left->_register, eax);
-	}
 
 	spill(edx);
 
-	cout << "\tcltd" << endl;
-	cout << "\tidivl\t" << _right << endl;
+	code << "\tcltd" << '\n';
+	code << "\tidivl\t" << _right << '\n';
 
 	release(_right);
-	deallocate(_left->_register);
+	deallocate(eax);
 	assign(_result, _token == '/' ? eax : edx);
 	break;
 
@@ -719,13 +1226,26 @@ void Unary::generate()
     switch(_token) {
     case NEGATE:
 	getreg(_result, _expr);
-	cout << "\tnegl\t" << _result << endl;
+	code << "\tnegl\t" << _result << '\n';
 	break;
 
 
     case INT:
+	if (isHomed(_expr) && homes[_expr]->byte().empty())
+	    load(_expr);
+
 	assign(_result, allocate());
-	cout << "\tmovsbl\t" << _expr << ", " << _result << endl;
+
+	if (isNumber(_expr))
+	    code << "\tmovl\t$" << (int) (char) valueOf(_expr);
+	else if (regof(_expr) != nullptr)
+	    code << "\tmovsbl\t" << regof(_expr)->byte();
+	else if (isHomed(_expr))
+	    code << "\tmovsbl\t" << homes[_expr]->byte();
+	else
+	    code << "\tmovsbl\t" << _expr;
+
+	code << ", " << _result << '\n';
 	break;
     }
 
@@ -741,8 +1261,10 @@ void Unary::generate()
 
 void Copy::generate()
 {
-    if (isNumber(_expr) && isVariable(_result))
+    if (isNumber(_expr) && isVariable(_result)) {
+	deallocate(regof(_result));
 	store(valueOf(_expr), _result);
+    }
 
     else {
 	getreg(_result, _expr);
@@ -751,6 +1273,54 @@ void Copy::generate()
 }
 
 
+/*
+ * Function:	Phi::generate
+ *
+ * Description:	Phi statements are replaced with copies when leaving SSA
+ *		form, so none should remain by the time code is generated.
+ */
+
+void Phi::generate()
+{
+    assert(0);
+}
+
+
+/*
+ * Function:	extend (private)
+ *
+ * Description:	Return an operand for the given array index that can be
+ *		added to an address.  On x86-64, an index that is not a
+ *		constant is first sign-extended in place in its register.
+ */
+
+static string extend(Symbol *sym)
+{
+    Register *reg;
+
+
+    if (!target64 || isNumber(sym)) {
+	if (regof(sym) != nullptr)
+	    return regof(sym)->name();
+
+	return operand(sym);
+    }
+
+    if (regof(sym) != nullptr)
+	reg = regof(sym);
+    else if (isHomed(sym))
+	reg = homes[sym];
+    else {
+	load(sym);
+	reg = regof(sym);
+    }
+
+    code << "\tmovslq\t" << reg->name() << ", ";
+    code << reg->name(SIZEOF_PTR) << '\n';
+    return reg->name(SIZEOF_PTR);
+}
+
+
 /*
  * Function:	Index::generate
  *
@@ -759,31 +1329,38 @@ void Copy::generate()
 
 void Index::generate()
 {
+    string index;
+
+
     /* Global variable: static address */
 
-    if (_array->kind() == GLOBAL) {
+    if (_array->kind() == GLOBAL && !target64) {
 	getreg(_result, _index);
-	cout << "\taddl\t" << operand(_array) << ", " << _result << endl;
+	code << "\taddl\t" << operand(_array) << ", " << _result << '\n';
 
 
     /* Parameter: address is already given as the parameter */
 
     } else if (_array->type().isPointer()) {
 	getreg(_result, _index);
-	cout << "\taddl\t" << _array << ", " << _result << endl;
+	index = extend(_result);
+	code << "\tadd" << suffix(SIZEOF_PTR) << "\t" << _array << ", ";
+	code << index << '\n';
 
 
-    /* Local: need to compute address */
+    /* Local, or global on x86-64: need to compute address */
 
     } else {
 	assign(_result, allocate());
-	load(_array, _result->_register);
-	//cout << "\tleal\t" << operand(_array) << ", " << _result << endl;
-	cout << "\taddl\t" << _index << ", " << _result << endl;
+	load(_array, regof(_result));
+	//code << "\tleal\t" << operand(_array) << ", " << _result << '\n';
+	index = extend(_index);
+	code << "\tadd" << suffix(SIZEOF_PTR) << "\t" << index << ", ";
+	code << regof(_result)->name(SIZEOF_PTR) << '\n';
 	release(_index);
     }
 
-    iload(_result->_register, _result->_register, basesize(_array));
+    iload(regof(_result), regof(_result), basesize(_array));
     release(_array);
     save(_result);
 }
@@ -797,27 +1374,34 @@ void Index::generate()
 
 void Update::generate()
 {
+    string index;
+
+
     /* Global variable: static address */
 
-    if (_array->kind() == GLOBAL) {
+    if (_array->kind() == GLOBAL && !target64) {
 	getreg(_array, _index);
-	cout << "\taddl\t" << operand(_array) << ", " << _array << endl;
+	code << "\taddl\t" << operand(_array) << ", " << _array << '\n';
 
 
     /* Parameter: address is already given as the parameter */
 
     } else if (_array->type().isPointer()) {
 	getreg(_array, _index);
-	cout << "\taddl\t" << operand(_array) << ", " << _array << endl;
+	index = extend(_array);
+	code << "\tadd" << suffix(SIZEOF_PTR) << "\t" << operand(_array);
+	code << ", " << index << '\n';
 
 
-    /* Local: need to compute address */
+    /* Local, or global on x86-64: need to compute address */
 
     } else {
 	assign(_array, allocate());
-	load(_array, _array->_register);
-	//cout << "\tleal\t" << operand(_array) << ", " << _array << endl;
-	cout << "\taddl\t" << _index << ", " << _array << endl;
+	load(_array, regof(_array));
+	//code << "\tleal\t" << operand(_array) << ", " << _array << '\n';
+	index = extend(_index);
+	code << "\tadd" << suffix(SIZEOF_PTR) << "\t" << index << ", ";
+	code << regof(_array)->name(SIZEOF_PTR) << '\n';
 	release(_index);
     }
 
@@ -825,73 +1409,153 @@ void Update::generate()
     /* Load the expression if necessary */
 
     if (isNumber(_expr))
-	istore(valueOf(_expr), _array->_register, basesize(_array));
+	istore(valueOf(_expr), regof(_array), basesize(_array));
 
     else {
 	Registers pool = registers;
 
-	shrink_pool(pool, _array->_register);
+	shrink_pool(pool, regof(_array));
 	load(_expr, pool);
 
-	assert(_expr->_register != _array->_register);
-	istore(_expr->_register, _array->_register, basesize(_array));
+	assert(regof(_expr) != regof(_array));
+	istore(regof(_expr), regof(_array), basesize(_array));
 	release(_expr);
     }
 
-    deallocate(_array->_register);
+    deallocate(regof(_array));
+}
+
+
+/*
+ * Function:	numberStrings
+ *
+ * Description:	Number every string literal in advance, so that functions
+ *		can then be generated concurrently without changing the
+ *		table of strings.
+ */
+
+void numberStrings()
+{
+    for (auto sym : getLiterals())
+	if (sym->kind() == STRLIT)
+	    number(sym);
 }
 
 
 /*
  * Function:	generateFunction
  *
- * Description:	Generate code for the given function.
+ * Description:	Generate code for the given function, writing it to the
+ *		given stream.
  */
 
-void generateFunction(Function &function)
+void generateFunction(Function &function, ostream &out)
 {
     Blocks blocks;
-    unsigned num_formals;
+    unsigned num_formals, num_registers;
     const Symbols &symbols = function.locals->symbols();
     string name;
+    Timer timer(function.stats.phases[GENERATION]);
+
+
+    /* Select the registers for the target. */
+
+    if (target64) {
+	caller_saved = {eax, ecx, edx, rsi, rdi, r8, r9, r10, r11};
+	callee_saved = {ebx, r12, r13, r14, r15};
+    } else {
+	caller_saved = {eax, ecx, edx};
+	callee_saved = {ebx, esi, edi};
+    }
 
+    registers = caller_saved;
 
-    /* Assign offsets to the parameters and local variables. */
+
+    /* Assign offsets to the parameters and local variables.  Any
+       parameters passed in registers are given locations like local
+       variables. */
 
     offset = 0;
     max_args = 0;
     param_offset = SIZEOF_REG * 2;
     num_formals = function.symbol->type().parameters()->size();
+    num_registers = 0;
+
+    if (target64)
+	num_registers = min(num_formals, (unsigned) parameters.size());
+
+    stack_params = num_formals - num_registers;
 
     for (unsigned i = 0; i < symbols.size(); i ++)
-	if (i < num_formals)
-	    symbols[i]->_offset = param_offset + SIZEOF_ARG * i;
+	if (i >= num_registers && i < num_formals)
+	    symbols[i]->_offset =
+		param_offset + SIZEOF_ARG * (i - num_registers);
 	else {
 	    offset -= symbols[i]->type().size();
 	    symbols[i]->_offset = offset;
 	}
 
 
-    /* Emit our prologue. */
+    /* Compute liveness and give the long-lived symbols their homes. */
+
+    rebuildFlowgraph(function);
+    return_label = function.stmts.back()->asLabel();
+
+    blocks = getBlocks(function);
+    doLVA(function);
+    allocateHomes(blocks);
+    saved.clear();
+
+    for (auto reg : callee_saved)
+	for (auto &home : homes)
+	    if (home.second == reg) {
+		saved.push_back(reg);
+		break;
+	    }
+
+
+    /* Emit our prologue, saving any callee-saved registers we use and
+       moving the parameters to where they live. */
 
     name = function.symbol->name();
-    cout << global_prefix << name << ":" << endl;
+    code << global_prefix << name << ":" << '\n';
 
-    cout << "\tpushl\t%ebp" << endl;
-    cout << "\tmovl\t%esp, %ebp" << endl;
-    cout << "\tsubl\t$" << name << ".size, %esp" << endl;
+    code << "\tpush" << suffix(SIZEOF_REG) << "\t" << frame_pointer << '\n';
+    code << "\tmov" << suffix(SIZEOF_REG) << "\t" << stack_pointer << ", ";
+    code << frame_pointer << '\n';
+    code << "\tsub" << suffix(SIZEOF_REG) << "\t$" << name << ".size, ";
+    code << stack_pointer << '\n';
 
+    saves = offset;
 
-    /* Generate code for the function body. */
+    for (auto reg : saved) {
+	offset -= SIZEOF_REG;
+	code << "\tmov" << suffix(SIZEOF_REG) << "\t" << reg->name(SIZEOF_REG);
+	code << ", " << offset << "(" << frame_pointer << ")" << '\n';
+    }
 
-    rebuildFlowgraph(function);
-    return_label = function.stmts.back()->asLabel();
+    for (unsigned i = 0; i < num_formals; i ++)
+	if (isHomed(symbols[i])) {
+	    code << "\tmovl\t";
 
+	    if (i < num_registers)
+		code << parameters[i];
+	    else
+		code << symbols[i]->_offset << "(" << frame_pointer << ")";
 
-    blocks = getBlocks(function);
+	    code << ", " << homes[symbols[i]] << '\n';
+
+	} else if (i < num_registers)
+	    store(parameters[i], symbols[i]);
+
+
+    /* Generate code for the function body. */
 
     for (auto block : blocks) {
-	for (auto it = block->first(); it != block->last(); it ++)
+	computeNextUses(block);
+	position = 0;
+
+	for (auto it = block->first(); it != block->last(); it ++, position ++)
 	    (*it)->generate();
 
 	for (auto reg : registers)
@@ -902,15 +1566,28 @@ void generateFunction(Function &function)
     /* Generate our epilogue. */
 
     return_label->generate();
-
-    cout << "\tmovl\t%ebp, %esp" << endl;
-    cout << "\tpopl\t%ebp" << endl;
-    cout << "\tret" << endl << endl;
+    restoreFrame();
+    code << "\tret\n\n";
 
     offset -= max_args * SIZEOF_ARG;
     offset -= align(offset - param_offset);
-    cout << "\t.set\t" << name << ".size, " << -offset << endl;
-    cout << "\t.globl\t" << global_prefix << name << endl << endl;
+    code << "\t.set\t" << name << ".size, " << -offset << '\n';
+    code << "\t.globl\t" << global_prefix << name << "\n\n";
+
+
+    /* Write out the code, after any peephole optimizations. */
+
+    if (peephole_on) {
+	Instructions insns = parseInstructions(code.str());
+	optimizeInstructions(insns);
+
+	for (auto &insn : insns)
+	    out << insn << '\n';
+
+    } else
+	out << code.str();
+
+    code.str("");
 }
 
 
@@ -927,8 +1604,8 @@ void generateGlobals(Scope *globals)
 
     for (unsigned i = 0; i < symbols.size(); i ++)
 	if (symbols[i]->kind() == GLOBAL && !symbols[i]->type().isFunction()) {
-	    cout << "\t.comm\t" << global_prefix << symbols[i]->name();
-	    cout << ", " << symbols[i]->type().size() << endl;
+	    output << "\t.comm\t" << global_prefix << symbols[i]->name();
+	    output << ", " << symbols[i]->type().size() << '\n';
 	}
 
     Symbols literals = getLiterals();
@@ -936,11 +1613,11 @@ void generateGlobals(Scope *globals)
     for (unsigned i = 0; i < literals.size(); i ++)
 	if (literals[i]->kind() == STRLIT) {
 	    if (!inDataSegment) {
-		cout << "\t.data" << endl;
+		output << "\t.data" << '\n';
 		inDataSegment = true;
 	    }
 
-	    cout << string_prefix << strings[literals[i]] << ":\t.asciz\t";
-	    cout << literals[i]->name() << endl;
+	    output << string_prefix << number(literals[i]) << ":\t.asciz\t";
+	    output << literals[i]->name() << '\n';
 	}
 }
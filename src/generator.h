@@ -7,9 +7,12 @@
 
 # ifndef GENERATOR_H
 # define GENERATOR_H
+# include <ostream>
 # include "Function.h"
+# include "emitter.h"
 
-void generateFunction(Function &function);
+void numberStrings();
+void generateFunction(Function &function, std::ostream &out = output);
 void generateGlobals(Scope *globals);
 
 # endif /* GENERATOR_H */
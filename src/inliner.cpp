@@ -0,0 +1,392 @@
+/*
+ * File:	inliner.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for inlining functions at their call sites.
+ *
+ *		Once a function has been optimized, a copy of its
+ *		statements is saved if it is small enough to be worth
+ *		inlining, is not directly recursive, and has no local
+ *		arrays.  The copy refers only to symbols of its own, so
+ *		it remains valid once the function itself is released.
+ *		Since a function is compiled after the functions it calls,
+ *		whether in order or bottom-up over the call graph, the copy
+ *		of a function already includes any calls that were inlined
+ *		into it.
+ *
+ *		At a call site, the copy is cloned in place of the call,
+ *		with fresh locals and temporaries and fresh labels.  Each
+ *		scalar parameter becomes a local assigned its argument,
+ *		while an array parameter, which is just the address of
+ *		the array, is replaced with its argument.  Each return
+ *		assigns the result of the call and jumps to the end of the
+ *		copy.  The other passes then optimize the result along
+ *		with the rest of the caller.
+ *
+ *		The smallest functions are always inlined, and somewhat
+ *		larger ones only when called from within a loop.  The
+ *		calls in the most deeply nested loops are inlined first,
+ *		until the caller has grown by as much as allowed.
+ */
+
+# include <string>
+# include <cassert>
+# include <algorithm>
+# include <unordered_map>
+# include "flowgraph.h"
+# include "translator.h"
+# include "tokens.h"
+# include "loops.h"
+# include "inliner.h"
+
+using namespace std;
+
+static const unsigned smallSize = 8;
+static const unsigned largeSize = 32;
+static const unsigned minGrowth = 64;
+
+struct Site {
+    unsigned depth;
+    Call *call;
+    const Body *body;
+};
+
+struct Renaming {
+    string prefix, suffix;
+    unordered_map<Symbol *, Symbol *> symbols;
+    unordered_map<Label *, Label *> labels;
+};
+
+
+/*
+ * Function:	rename (private)
+ *
+ * Description:	Return the copy of the given symbol, creating it if
+ *		necessary.  Only locals and temporaries are copied.  The
+ *		name of a local is decorated so that it is distinct from
+ *		any other local in the function, since some passes compare
+ *		symbols by name.
+ */
+
+static Symbol *rename(Symbol *sym, Renaming &names)
+{
+    if (sym == nullptr || (sym->kind() != LOCAL && sym->kind() != TEMP))
+	return sym;
+
+    Symbol *&copy = names.symbols[sym];
+
+    if (copy == nullptr) {
+	if (sym->kind() == TEMP)
+	    copy = makeTemp();
+	else
+	    copy = new (*Arena::current()) Symbol(names.prefix +
+		sym->name() + names.suffix, sym->type(), sym->kind());
+    }
+
+    return copy;
+}
+
+
+/*
+ * Function:	rename (private)
+ *
+ * Description:	Return the copy of the given label, creating it if
+ *		necessary.
+ */
+
+static Label *rename(Label *label, Renaming &names)
+{
+    Label *&copy = names.labels[label];
+
+
+    if (copy == nullptr)
+	copy = new Label();
+
+    return copy;
+}
+
+
+/*
+ * Function:	clone (private)
+ *
+ * Description:	Return a copy of the given statement that refers to the
+ *		copies of its symbols and labels, or null if the statement
+ *		need not be copied.
+ */
+
+static Statement *clone(Statement *stmt, Renaming &names)
+{
+    bool tail;
+    Symbols args;
+    Label *label;
+    Jump *jump;
+    Branch *branch;
+    Call *call;
+    Return *ret;
+    Binary *binary;
+    Unary *unary;
+    Copy *copy;
+    Index *index;
+    Update *update;
+
+
+    if ((label = stmt->asLabel()) != nullptr)
+	return rename(label, names);
+
+    if ((jump = dynamic_cast<Jump *>(stmt)) != nullptr)
+	return new Jump(rename(jump->_target, names));
+
+    if ((branch = dynamic_cast<Branch *>(stmt)) != nullptr)
+	return new Branch(branch->_token, rename(branch->_left, names),
+	    rename(branch->_right, names), rename(branch->_target, names));
+
+    if ((call = dynamic_cast<Call *>(stmt)) != nullptr) {
+	for (auto arg : call->_arguments)
+	    args.push_back(rename(arg, names));
+
+	tail = call->_tail;
+	call = new Call(rename(call->_result, names), call->_function, args);
+	call->_tail = tail;
+	return call;
+    }
+
+    if ((ret = dynamic_cast<Return *>(stmt)) != nullptr)
+	return new Return(rename(ret->_expr, names));
+
+    if ((binary = dynamic_cast<Binary *>(stmt)) != nullptr)
+	return new Binary(binary->_token, rename(binary->_result, names),
+	    rename(binary->_left, names), rename(binary->_right, names));
+
+    if ((unary = dynamic_cast<Unary *>(stmt)) != nullptr)
+	return new Unary(unary->_token, rename(unary->_result, names),
+	    rename(unary->_expr, names));
+
+    if ((copy = dynamic_cast<Copy *>(stmt)) != nullptr)
+	return new Copy(rename(copy->_result, names),
+	    rename(copy->_expr, names));
+
+    if ((index = dynamic_cast<Index *>(stmt)) != nullptr)
+	return new Index(rename(index->_result, names),
+	    rename(index->_array, names), rename(index->_index, names));
+
+    if ((update = dynamic_cast<Update *>(stmt)) != nullptr)
+	return new Update(rename(update->_array, names),
+	    rename(update->_index, names), rename(update->_expr, names));
+
+    assert(dynamic_cast<Null *>(stmt) != nullptr);
+    return nullptr;
+}
+
+
+/*
+ * Function:	saveForInlining
+ *
+ * Description:	Save a copy of the statements of the given function if it
+ *		may be inlined.
+ */
+
+void saveForInlining(Function &function)
+{
+    Call *call;
+    Arena *previous;
+    Statement *copy;
+    Renaming names;
+    unsigned count, size;
+    Body &body = function.saved;
+    const Symbols &symbols = function.locals->symbols();
+
+
+    count = function.symbol->type().parameters()->size();
+
+    for (unsigned i = count; i < symbols.size(); i ++)
+	if (symbols[i]->type().isArray())
+	    return;
+
+    size = 0;
+
+    for (auto stmt : function.stmts) {
+	if (stmt->asLabel() != nullptr || dynamic_cast<Null *>(stmt))
+	    continue;
+
+	if (dynamic_cast<Phi *>(stmt) != nullptr)
+	    return;
+
+	call = dynamic_cast<Call *>(stmt);
+
+	if (call != nullptr && call->_function == function.symbol)
+	    return;
+
+	if (++ size > largeSize)
+	    return;
+    }
+
+    previous = Arena::current();
+    body.arena = new Arena();
+    body.size = size;
+    Arena::current(body.arena);
+
+    for (unsigned i = 0; i < count; i ++)
+	body.parameters.push_back(rename(symbols[i], names));
+
+    for (auto stmt : function.stmts)
+	if ((copy = clone(stmt, names)) != nullptr)
+	    body.stmts.push_back(copy);
+
+    Arena::current(previous);
+}
+
+
+/*
+ * Function:	expand (private)
+ *
+ * Description:	Replace the given call in the given function with a copy
+ *		of the given body, whose locals are numbered with the
+ *		given instance.  The last statement of the body is the
+ *		label of its exit, to which each return is redirected.  A
+ *		tail call in the body is no longer one, and is made as
+ *		usual before leaving with its result.
+ */
+
+static void expand(Function &function, Call *call, const Body &body,
+	unsigned instance)
+{
+    Label *end;
+    Call *tail;
+    Return *ret;
+    Statement *copy;
+    Symbol *param, *arg, *value;
+    Renaming names;
+    Statements::iterator pos(call);
+
+
+    names.prefix = call->_function->name() + ".";
+    names.suffix = "." + to_string(instance);
+
+    for (unsigned i = 0; i < body.parameters.size(); i ++) {
+	param = body.parameters[i];
+	arg = call->_arguments[i];
+
+	if (param->type().isPointer())
+	    names.symbols[param] = arg;
+	else
+	    function.stmts.insert(pos, new Copy(rename(param, names), arg));
+    }
+
+    end = rename(body.stmts.back()->asLabel(), names);
+
+    for (auto stmt : body.stmts) {
+	if ((ret = dynamic_cast<Return *>(stmt)) != nullptr)
+	    value = rename(ret->_expr, names);
+
+	else {
+	    copy = clone(stmt, names);
+	    function.stmts.insert(pos, copy);
+	    tail = dynamic_cast<Call *>(copy);
+
+	    if (tail == nullptr || !tail->_tail)
+		continue;
+
+	    value = (call->_result != nullptr ? makeTemp() : nullptr);
+	    tail->_result = value;
+	    tail->_tail = false;
+	}
+
+	if (call->_result != nullptr && value != nullptr) {
+	    if (call->_function->type().specifier() == CHAR)
+		function.stmts.insert(pos, new Unary(INT, call->_result, value));
+	    else
+		function.stmts.insert(pos, new Copy(call->_result, value));
+	}
+
+	function.stmts.insert(pos, new Jump(end));
+    }
+
+    function.stmts.erase(pos);
+    delete call;
+}
+
+
+/*
+ * Function:	inlinable (private)
+ *
+ * Description:	Return the saved body of the function called by the given
+ *		statement in the given function, or null if the call
+ *		cannot be inlined.  A string literal cannot take the place
+ *		of an array parameter.
+ */
+
+static const Body *inlinable(Function &function, Statement *stmt)
+{
+    Call *call;
+
+
+    call = dynamic_cast<Call *>(stmt);
+
+    if (call == nullptr || call->_function == function.symbol)
+	return nullptr;
+
+    auto it = functions.find(call->_function);
+
+    if (it == functions.end() || it->second.saved.arena == nullptr)
+	return nullptr;
+
+    const Body &body = it->second.saved;
+
+    if (body.parameters.size() != call->_arguments.size())
+	return nullptr;
+
+    for (unsigned i = 0; i < body.parameters.size(); i ++)
+	if (body.parameters[i]->type().isPointer())
+	    if (call->_arguments[i]->kind() == STRLIT)
+		return nullptr;
+
+    return &body;
+}
+
+
+/*
+ * Function:	inlineCalls
+ *
+ * Description:	Inline the profitable calls in the given function and
+ *		return whether any were inlined.  A call is more likely to
+ *		be profitable the more deeply it is nested in loops.
+ */
+
+bool inlineCalls(Function &function)
+{
+    const Body *body;
+    unsigned budget, count;
+    vector<Site> sites;
+    unordered_map<Block *, unsigned> depths;
+
+
+    computeDominators(function);
+
+    for (auto &loop : findLoops(function))
+	for (auto block : loop.blocks)
+	    depths[block] ++;
+
+    for (auto block : getBlocks(function))
+	for (auto stmt : *block)
+	    if ((body = inlinable(function, stmt)) != nullptr)
+		if (body->size <= smallSize || depths[block] > 0)
+		    sites.push_back({depths[block], (Call *) stmt, body});
+
+    stable_sort(sites.begin(), sites.end(),
+	[](const Site &a, const Site &b) { return a.depth > b.depth; });
+
+    count = 0;
+    budget = max(function.stmts.size(), minGrowth);
+
+    for (auto &site : sites)
+	if (site.body->size <= budget) {
+	    budget -= site.body->size;
+	    expand(function, site.call, *site.body, ++ count);
+	}
+
+    if (count == 0)
+	return false;
+
+    rebuildFlowgraph(function);
+    return true;
+}
@@ -0,0 +1,16 @@
+/*
+ * File:	inliner.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		saving the bodies of small functions and inlining them
+ *		at their call sites.
+ */
+
+# ifndef INLINER_H
+# define INLINER_H
+# include "Function.h"
+
+void saveForInlining(Function &function);
+bool inlineCalls(Function &function);
+
+# endif /* INLINER_H */
@@ -6,6 +6,7 @@
  *		literals as symbols.
  */
 
+# include <mutex>
 # include <cassert>
 # include <unordered_map>
 # include "literal.h"
@@ -13,6 +14,7 @@
 
 using namespace std;
 static unordered_map<string, Symbol *> literals;
+static mutex literals_lock;
 
 
 /*
@@ -23,13 +25,16 @@ static unordered_map<string, Symbol *> literals;
  *		as symbols; however, we only need one copy of each.  The
  *		type of the literal is inferred from its name.  A string
  *		literal is first parsed and then escaped in order to create
- *		a canonical version.
+ *		a canonical version.  Since the optimizer may create
+ *		literals while compiling functions concurrently, the table
+ *		is locked.
  */
 
 Symbol *makeLiteral(const string &name)
 {
     Symbol *symbol;
     string parsed, escaped;
+    lock_guard<mutex> guard(literals_lock);
 
 
     if (name[0] == '"') {
@@ -76,6 +81,7 @@ Symbol *makeLiteral(int value)
 const Symbols getLiterals()
 {
     Symbols all;
+    lock_guard<mutex> guard(literals_lock);
 
     for (auto p : literals)
 	all.push_back(p.second);
@@ -107,3 +113,16 @@ bool isNumber(Symbol *sym)
 {
     return sym->kind() == NUM;
 }
+
+
+/*
+ * Function:	isLiteral
+ *
+ * Description:	Check if the given symbol is a literal of any kind, and
+ *		therefore can never be assigned.
+ */
+
+bool isLiteral(Symbol *sym)
+{
+    return sym->kind() == NUM || sym->kind() == CHARLIT || sym->kind() == STRLIT;
+}
@@ -17,5 +17,6 @@ const Symbols getLiterals();
 
 int valueOf(Symbol *sym);
 bool isNumber(Symbol *sym);
+bool isLiteral(Symbol *sym);
 
 # endif /* LITERAL_H */
@@ -0,0 +1,759 @@
+/*
+ * File:	loops.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for finding natural loops in the control-flow
+ *		graph, for loop-invariant code motion, and for the strength
+ *		reduction of induction variables.
+ *
+ *		A statement is moved out of a loop into a new preheader,
+ *		a block that is executed once just before the loop is
+ *		entered, if it always computes the same value within the
+ *		loop and moving it cannot change what any other statement
+ *		sees.  The liveness of each variable and the kill sets of
+ *		the statements in the loop provide the proof.  Moving a
+ *		statement out of an inner loop may make it invariant in an
+ *		enclosing loop, so the loops are processed innermost first
+ *		and the flowgraph is rebuilt after each loop is changed.
+ *
+ *		Induction variables are integer variables that change by
+ *		a constant amount on each assignment in the loop, such as
+ *		a loop index and the temporaries copied to and from it.
+ *		A multiplication of an induction variable by a constant,
+ *		as is computed for each array index, is reduced to an
+ *		addition by keeping a scaled copy of each variable in its
+ *		family up to date alongside it.  Induction variables left
+ *		with no use but their own updates are then removed.
+ */
+
+# include <cassert>
+# include <climits>
+# include <map>
+# include <algorithm>
+# include <unordered_map>
+# include "flowgraph.h"
+# include "optimizer.h"
+# include "translator.h"
+# include "literal.h"
+# include "loops.h"
+# include "modref.h"
+
+using namespace std;
+
+struct Induction {
+    Symbol *result, *source;
+    long long step;
+    Block *block;
+    Statements::iterator def;
+};
+
+typedef vector<Induction> Inductions;
+
+
+/*
+ * Function:	findLoops
+ *
+ * Description:	Return the natural loops in the control-flow graph,
+ *		innermost first, with the blocks of each loop in their
+ *		sequential order.  The dominators must be up to date.
+ */
+
+Loops findLoops(Function &function)
+{
+    Loops loops;
+    Blocks blocks, stack;
+    unordered_map<Block *, unsigned> index;
+
+
+    blocks = getBlocks(function);
+
+    for (auto block : blocks)
+	for (auto header : block->successors()) {
+	    if (!dominates(header, block))
+		continue;
+
+	    if (index.count(header) == 0) {
+		index[header] = loops.size();
+		loops.push_back(Loop());
+		loops.back().header = header;
+		loops.back().members.insert(header);
+	    }
+
+	    Loop &loop = loops[index[header]];
+	    stack.push_back(block);
+
+	    while (!stack.empty()) {
+		Block *member = stack.back();
+		stack.pop_back();
+
+		if (loop.members.insert(member).second)
+		    for (auto pred : member->predecessors())
+			if (dominates(header, pred))
+			    stack.push_back(pred);
+	    }
+	}
+
+    for (auto &loop : loops)
+	for (auto block : blocks)
+	    if (loop.contains(block))
+		loop.blocks.push_back(block);
+
+    stable_sort(loops.begin(), loops.end(),
+	[](const Loop &a, const Loop &b) {
+	    return a.blocks.size() < b.blocks.size();
+	});
+
+    return loops;
+}
+
+
+/*
+ * Function:	insertPreheader
+ *
+ * Description:	Insert a preheader for the given loop and return the
+ *		position before which statements to be executed once on
+ *		entry to the loop should be inserted.  The preheader is a
+ *		new label placed just before the header.  Every jump or
+ *		branch to the header from outside the loop is redirected
+ *		to the preheader, and if control would fall into the
+ *		preheader from within the loop, a jump to the header is
+ *		added instead.  The flowgraph must be rebuilt afterwards.
+ */
+
+Statements::iterator insertPreheader(Function &function, const Loop &loop)
+{
+    Statement *last;
+    Label *header, *preheader;
+    Statements::iterator pos;
+
+
+    pos = loop.header->first();
+    header = (*pos)->asLabel();
+    preheader = new Label();
+    assert(pos != function.stmts.begin());
+
+    for (auto block : getBlocks(function))
+	if (block->next() == loop.header && loop.contains(block))
+	    if ((*prev(pos))->fallsThru())
+		function.stmts.insert(pos, new Jump(header));
+
+    for (auto block : getBlocks(function))
+	if (!loop.contains(block) && block->begin() != block->end()) {
+	    last = *prev(block->end());
+
+	    if (last->target() == header)
+		last->target(preheader);
+	}
+
+    function.stmts.insert(pos, preheader);
+    return pos;
+}
+
+
+/*
+ * Function:	mayTrap (private)
+ *
+ * Description:	Return whether the given statement may trap, and so must
+ *		not be executed unless it would have been anyway.  Only a
+ *		division by a divisor not known to be positive may trap.
+ */
+
+static bool mayTrap(Statement *stmt)
+{
+    Binary *binary = dynamic_cast<Binary *>(stmt);
+
+
+    if (binary == nullptr || (binary->_token != '/' && binary->_token != '%'))
+	return false;
+
+    return !isNumber(binary->_right) || valueOf(binary->_right) <= 0;
+}
+
+
+/*
+ * Function:	countDefinitions (private)
+ *
+ * Description:	Count the number of times each symbol is assigned in the
+ *		given loop, and return whether the loop contains a call
+ *		that may assign any global.  A call whose callee is
+ *		summarized is counted as assigning the globals it may.
+ */
+
+static bool countDefinitions(const Loop &loop,
+	unordered_map<Symbol *, unsigned> &defs)
+{
+    Call *call;
+    const Effects *effects;
+    bool calls = false;
+
+
+    for (auto block : loop.blocks)
+	for (auto stmt : *block) {
+	    if (stmt->result() != nullptr)
+		defs[stmt->result()] ++;
+
+	    if ((call = dynamic_cast<Call *>(stmt)) != nullptr) {
+		if ((effects = effectsOf(call)) == nullptr)
+		    calls = true;
+		else
+		    for (auto sym : effects->writes)
+			defs[sym] ++;
+	    }
+	}
+
+    return calls;
+}
+
+
+/*
+ * Function:	findExits (private)
+ *
+ * Description:	Return the edges leaving the given loop, as pairs of a
+ *		block in the loop and its successor outside the loop.
+ */
+
+static vector<pair<Block *, Block *>> findExits(const Loop &loop)
+{
+    vector<pair<Block *, Block *>> exits;
+
+
+    for (auto block : loop.blocks)
+	for (auto succ : block->successors())
+	    if (!loop.contains(succ))
+		exits.push_back(make_pair(block, succ));
+
+    return exits;
+}
+
+
+/*
+ * Function:	findInvariants (private)
+ *
+ * Description:	Return the positions of the statements in the given loop
+ *		that can be moved to its preheader, in an order that
+ *		respects their dependences.  A statement may be moved if:
+ *
+ *		1. it is an arithmetic or copy statement whose result is
+ *		   a local or temporary that is assigned nowhere else in
+ *		   the loop,
+ *
+ *		2. each operand is a constant, is not assigned in the loop
+ *		   (a global must not be, by a call either), or is assigned
+ *		   only by a statement that is itself moved,
+ *
+ *		3. the result is not live on entry to the header, so no
+ *		   use in the loop sees a value from before the loop or
+ *		   from the previous iteration, and
+ *
+ *		4. the result is not live on any exit from the loop unless
+ *		   the statement dominates that exit, in which case the
+ *		   value seen after the loop is the same.  A statement
+ *		   that may trap must dominate every exit.
+ */
+
+static vector<Statements::iterator> findInvariants(const Loop &loop)
+{
+    bool calls, changed;
+    vector<pair<Block *, Block *>> exits;
+    vector<Statements::iterator> invariants;
+    unordered_map<Symbol *, unsigned> defs;
+    unordered_set<Statement *> moved;
+    unordered_set<Symbol *> hoisted;
+
+
+    calls = countDefinitions(loop, defs);
+    exits = findExits(loop);
+
+    auto invariant = [&](Symbol *sym) {
+	int kind = sym->kind();
+
+	if (kind == NUM || kind == CHARLIT || kind == STRLIT)
+	    return true;
+
+	if (kind == GLOBAL && calls)
+	    return false;
+
+	return defs.count(sym) == 0 || hoisted.count(sym) > 0;
+    };
+
+    do {
+	changed = false;
+
+	for (auto block : loop.blocks)
+	    for (auto it = block->begin(); it != block->end(); it ++) {
+		Statement *stmt = *it;
+
+		if (moved.count(stmt) > 0)
+		    continue;
+
+		if (!dynamic_cast<Binary *>(stmt) &&
+			!dynamic_cast<Unary *>(stmt) &&
+			!dynamic_cast<Copy *>(stmt))
+		    continue;
+
+		Symbol *result = stmt->result();
+
+		if (result->kind() != LOCAL && result->kind() != TEMP)
+		    continue;
+
+		if (defs[result] != 1 || isLiveIn(loop.header, result))
+		    continue;
+
+		bool operands = true;
+
+		for (unsigned i = 0; i < stmt->uses(); i ++)
+		    operands = operands && invariant(stmt->use(i));
+
+		if (!operands)
+		    continue;
+
+		bool safe = true;
+
+		for (auto &exit : exits)
+		    if (!dominates(block, exit.first))
+			if (mayTrap(stmt) || isLiveIn(exit.second, result))
+			    safe = false;
+
+		if (safe) {
+		    invariants.push_back(it);
+		    moved.insert(stmt);
+		    hoisted.insert(result);
+		    changed = true;
+		}
+	    }
+
+    } while (changed);
+
+    return invariants;
+}
+
+
+/*
+ * Function:	hoistLoop (private)
+ *
+ * Description:	Move the invariant statements of the given loop to a new
+ *		preheader and return whether any were moved.
+ */
+
+static bool hoistLoop(Function &function, const Loop &loop)
+{
+    Statements::iterator pos;
+    vector<Statements::iterator> invariants;
+
+
+    invariants = findInvariants(loop);
+
+    if (invariants.empty())
+	return false;
+
+    pos = insertPreheader(function, loop);
+
+    for (auto it : invariants) {
+	Statement *stmt = *it;
+	function.stmts.erase(it);
+	function.stmts.insert(pos, stmt);
+    }
+
+    return true;
+}
+
+
+/*
+ * Function:	transformLoops (private)
+ *
+ * Description:	Apply the given transformation to each loop in the
+ *		function, innermost first unless otherwise requested, and
+ *		return whether any loop was changed.  Since a
+ *		transformation may insert a preheader, which changes the
+ *		labels, the flowgraph and the analyses are rebuilt and the
+ *		loops found again after each change.
+ */
+
+static bool transformLoops(Function &function,
+	bool (*transform)(Function &, const Loop &), bool outermost = false)
+{
+    bool changed, found;
+    Loops loops;
+
+
+    changed = false;
+
+    do {
+	found = false;
+	computeDominators(function);
+	doLVA(function);
+	loops = findLoops(function);
+
+	if (outermost)
+	    reverse(loops.begin(), loops.end());
+
+	for (auto &loop : loops)
+	    if (loop.header != function.entry && transform(function, loop)) {
+		rebuildFlowgraph(function);
+		found = changed = true;
+		break;
+	    }
+
+    } while (found);
+
+    return changed;
+}
+
+
+/*
+ * Function:	hoistInvariants
+ *
+ * Description:	Move the loop-invariant statements out of each loop in
+ *		the function and return whether any were moved.
+ */
+
+bool hoistInvariants(Function &function)
+{
+    return transformLoops(function, hoistLoop);
+}
+
+
+/*
+ * Function:	isInteger (private)
+ *
+ * Description:	Return whether the given symbol is an integer local or
+ *		temporary, which can only be assigned by a statement that
+ *		names it.
+ */
+
+static bool isInteger(Symbol *sym)
+{
+    if (sym->kind() != LOCAL && sym->kind() != TEMP)
+	return false;
+
+    return sym->type().isScalar() && sym->type().specifier() == INT;
+}
+
+
+/*
+ * Function:	inductionStep (private)
+ *
+ * Description:	If the given statement assigns to its result another
+ *		integer variable plus or minus a constant, or simply a
+ *		copy of it, then return that variable and set the step to
+ *		the constant.  Otherwise, return null.
+ */
+
+static Symbol *inductionStep(Statement *stmt, long long &step)
+{
+    Copy *copy;
+    Binary *binary;
+
+
+    step = 0;
+
+    if ((copy = dynamic_cast<Copy *>(stmt)) != nullptr)
+	return isInteger(copy->_expr) ? copy->_expr : nullptr;
+
+    if ((binary = dynamic_cast<Binary *>(stmt)) == nullptr)
+	return nullptr;
+
+    if (binary->_token == '+' && isNumber(binary->_left))
+	if (isInteger(binary->_right)) {
+	    step = valueOf(binary->_left);
+	    return binary->_right;
+	}
+
+    if (binary->_token == '+' || binary->_token == '-')
+	if (isNumber(binary->_right) && isInteger(binary->_left)) {
+	    step = valueOf(binary->_right);
+	    step = binary->_token == '-' ? -step : step;
+	    return binary->_left;
+	}
+
+    return nullptr;
+}
+
+
+/*
+ * Function:	findInductions (private)
+ *
+ * Description:	Return the induction variables of the given loop in the
+ *		order of their definitions.  An induction variable is an
+ *		integer variable assigned exactly once in the loop, to
+ *		another induction variable plus a constant.  We start with
+ *		every variable assigned in that form, and repeatedly drop
+ *		those whose source is not an induction variable.
+ */
+
+static Inductions findInductions(const Loop &loop)
+{
+    bool changed;
+    Induction ind;
+    Inductions inductions;
+    unordered_set<Symbol *> members;
+    unordered_map<Symbol *, unsigned> defs;
+
+
+    countDefinitions(loop, defs);
+
+    for (auto block : loop.blocks)
+	for (auto it = block->begin(); it != block->end(); it ++) {
+	    ind.source = inductionStep(*it, ind.step);
+	    ind.result = (*it)->result();
+
+	    if (ind.source != nullptr && isInteger(ind.result))
+		if (defs[ind.result] == 1) {
+		    ind.block = block;
+		    ind.def = it;
+		    inductions.push_back(ind);
+		}
+	}
+
+    do {
+	changed = false;
+	members.clear();
+
+	for (auto &ind : inductions)
+	    members.insert(ind.result);
+
+	for (unsigned i = 0; i < inductions.size(); i ++)
+	    if (members.count(inductions[i].source) == 0) {
+		inductions.erase(inductions.begin() + i --);
+		changed = true;
+	    }
+
+    } while (changed);
+
+    return inductions;
+}
+
+
+/*
+ * Function:	removeInductions (private)
+ *
+ * Description:	Remove the induction variables of the given loop whose
+ *		values are never used, other than to update induction
+ *		variables that are themselves removed, and return whether
+ *		any were removed.  Such variables are not found by dead
+ *		code elimination, since each update keeps the variable
+ *		live around the loop.
+ */
+
+static bool removeInductions(Function &function, const Loop &loop)
+{
+    bool changed;
+    Inductions inductions;
+    unordered_set<Symbol *> dead;
+
+
+    inductions = findInductions(loop);
+
+    for (auto &ind : inductions)
+	dead.insert(ind.result);
+
+    for (auto &exit : findExits(loop))
+	for (auto &ind : inductions)
+	    if (isLiveIn(exit.second, ind.result))
+		dead.erase(ind.result);
+
+    do {
+	changed = false;
+
+	for (auto block : loop.blocks)
+	    for (auto stmt : *block) {
+		if (stmt->result() != nullptr && dead.count(stmt->result()) > 0)
+		    continue;
+
+		for (unsigned i = 0; i < stmt->uses(); i ++)
+		    if (dead.erase(stmt->use(i)) > 0)
+			changed = true;
+	    }
+
+    } while (changed);
+
+    changed = false;
+
+    for (auto &ind : inductions)
+	if (dead.count(ind.result) > 0) {
+	    eraseStatement(function, ind.block, ind.def);
+	    changed = true;
+	}
+
+    return changed;
+}
+
+
+/*
+ * Function:	reduceLoop (private)
+ *
+ * Description:	Reduce the multiplications of induction variables by
+ *		constants in the given loop to additions, and return
+ *		whether any were reduced.  For each scale factor used
+ *		with a family of induction variables, each variable x in
+ *		the family is given a new temporary s, which is kept equal
+ *		to x times the factor: s is initialized in the preheader if
+ *		x is live on entry to the loop, and each assignment of y
+ *		plus c to x is followed by an assignment of the scaled y
+ *		plus c times the factor to s.  Each multiplication of x by
+ *		the factor is then replaced with a copy of s.
+ */
+
+static bool reduceLoop(Function &function, const Loop &loop)
+{
+    bool preheader;
+    long long step;
+    Binary *binary;
+    Statement *stmt;
+    Symbol *var, *shadow;
+    Statements::iterator pos;
+    Inductions inductions;
+    vector<pair<Symbol *, int>> scales;
+    vector<pair<Statements::iterator, pair<Symbol *, int>>> products;
+    unordered_map<Symbol *, Symbol *> family;
+    map<pair<Symbol *, int>, Symbol *> shadows;
+
+
+    inductions = findInductions(loop);
+
+    for (auto &ind : inductions)
+	family[ind.result] = ind.result;
+
+    auto root = [&](Symbol *sym) {
+	while (family[sym] != sym)
+	    sym = family[sym];
+
+	return sym;
+    };
+
+    for (auto &ind : inductions)
+	family[root(ind.result)] = root(ind.source);
+
+
+    /* Find the multiplications and the factors used with each family. */
+
+    for (auto block : loop.blocks)
+	for (auto it = block->begin(); it != block->end(); it ++) {
+	    binary = dynamic_cast<Binary *>(*it);
+
+	    if (binary == nullptr || binary->_token != '*')
+		continue;
+
+	    if (isNumber(binary->_right) && family.count(binary->_left))
+		var = binary->_left;
+	    else if (isNumber(binary->_left) && family.count(binary->_right))
+		var = binary->_right;
+	    else
+		continue;
+
+	    int factor = valueOf(var == binary->_left ? binary->_right :
+		binary->_left);
+
+	    if (!isInteger(binary->_result))
+		continue;
+
+	    products.push_back(make_pair(it, make_pair(var, factor)));
+	    pair<Symbol *, int> scale(root(var), factor);
+
+	    if (find(scales.begin(), scales.end(), scale) == scales.end())
+		scales.push_back(scale);
+	}
+
+    if (products.empty())
+	return false;
+
+
+    /* Make sure that every scaled step can be written as a literal. */
+
+    for (auto &ind : inductions)
+	for (auto &scale : scales) {
+	    step = ind.step * scale.second;
+
+	    if (root(ind.result) == scale.first)
+		if (step < INT_MIN || step > INT_MAX)
+		    return false;
+	}
+
+
+    /* Create the scaled variables and initialize them in the preheader. */
+
+    preheader = false;
+
+    for (auto &ind : inductions)
+	for (auto &scale : scales)
+	    if (root(ind.result) == scale.first) {
+		shadow = makeTemp();
+		shadows[make_pair(ind.result, scale.second)] = shadow;
+
+		if (isLiveIn(loop.header, ind.result)) {
+		    if (!preheader) {
+			pos = insertPreheader(function, loop);
+			preheader = true;
+		    }
+
+		    stmt = new Binary('*', shadow, ind.result,
+			makeLiteral(scale.second));
+		    function.stmts.insert(pos, stmt);
+		}
+	    }
+
+
+    /* Update the scaled variables along with the variables. */
+
+    for (auto &ind : inductions)
+	for (auto &scale : scales)
+	    if (root(ind.result) == scale.first) {
+		shadow = shadows[make_pair(ind.result, scale.second)];
+		var = shadows[make_pair(ind.source, scale.second)];
+
+		step = ind.step * scale.second;
+
+		if (step == 0)
+		    stmt = new Copy(shadow, var);
+		else if (step < 0 && step > INT_MIN)
+		    stmt = new Binary('-', shadow, var, makeLiteral(-step));
+		else
+		    stmt = new Binary('+', shadow, var, makeLiteral(step));
+
+		function.stmts.insert(next(ind.def), stmt);
+	    }
+
+
+    /* Replace each multiplication with a copy of its scaled variable. */
+
+    for (auto &product : products) {
+	binary = static_cast<Binary *>(*product.first);
+	shadow = shadows[product.second];
+	stmt = new Copy(binary->_result, shadow);
+	function.stmts.replace(product.first, stmt);
+	delete binary;
+    }
+
+    return true;
+}
+
+
+/*
+ * Function:	strengthReduceLoop (private)
+ *
+ * Description:	Remove the unused induction variables of the given loop,
+ *		or failing that, reduce its multiplications.
+ */
+
+static bool strengthReduceLoop(Function &function, const Loop &loop)
+{
+    return removeInductions(function, loop) || reduceLoop(function, loop);
+}
+
+
+/*
+ * Function:	reduceInductions
+ *
+ * Description:	Reduce the strength of the multiplications of induction
+ *		variables in each loop of the function, remove induction
+ *		variables that are no longer needed, and return whether
+ *		anything was changed.  The loops are visited outermost
+ *		first, so that a variable that is an induction variable of
+ *		an enclosing loop is given a single scaled copy, which
+ *		also serves the loops inside it.
+ */
+
+bool reduceInductions(Function &function)
+{
+    return transformLoops(function, strengthReduceLoop, true);
+}
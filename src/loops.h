@@ -0,0 +1,38 @@
+/*
+ * File:	loops.h
+ *
+ * Description:	This file contains the structure definition for natural
+ *		loops and the public function declarations for finding the
+ *		loops in the control-flow graph and optimizing them.
+ *
+ *		A natural loop is identified by a back edge, an edge whose
+ *		target dominates its source.  The target is the header of
+ *		the loop, and the body consists of the header and every
+ *		block that can reach the source of the back edge without
+ *		passing through the header.  Loops sharing a header are
+ *		combined into a single loop.
+ */
+
+# ifndef LOOPS_H
+# define LOOPS_H
+# include <vector>
+# include <unordered_set>
+# include "Function.h"
+
+struct Loop {
+    Block *header;
+    Blocks blocks;
+    std::unordered_set<Block *> members;
+
+    bool contains(Block *block) const { return members.count(block) > 0; }
+};
+
+typedef std::vector<Loop> Loops;
+
+Loops findLoops(Function &function);
+Statements::iterator insertPreheader(Function &function, const Loop &loop);
+
+bool hoistInvariants(Function &function);
+bool reduceInductions(Function &function);
+
+# endif /* LOOPS_H */
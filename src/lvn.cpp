@@ -0,0 +1,279 @@
+/*
+ * File:	lvn.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		the value table used by local value numbering.
+ *
+ *		Rather than removing a symbol from the list of holders of
+ *		its old value number when it is assigned a new one, we
+ *		simply check that the holder still has the value number
+ *		whenever it is asked for.  Every operation on the table is
+ *		therefore a constant number of hash table operations.
+ *
+ *		Within a scope, each change to the table is logged, along
+ *		with what it replaced, so that it can be undone in reverse
+ *		order when the scope is left.
+ */
+
+# include <utility>
+# include "tokens.h"
+# include "lvn.h"
+
+using namespace std;
+
+
+/*
+ * Function:	ValueTable::clear
+ *
+ * Description:	Forget all value numbers, as when starting a new block.
+ */
+
+void ValueTable::clear()
+{
+    _numbers.clear();
+    _exprs.clear();
+    _holders.clear();
+
+    _scopes.clear();
+    _numberLog.clear();
+    _exprLog.clear();
+    _holderLog.clear();
+}
+
+
+/*
+ * Function:	ValueTable::enterScope
+ *
+ * Description:	Enter a new scope, such as when descending to a child in
+ *		the dominator tree.
+ */
+
+void ValueTable::enterScope()
+{
+    Scope scope;
+
+
+    scope.numbers = _numberLog.size();
+    scope.exprs = _exprLog.size();
+    scope.holders = _holderLog.size();
+    scope.values = _holders.size();
+    _scopes.push_back(scope);
+}
+
+
+/*
+ * Function:	ValueTable::leaveScope
+ *
+ * Description:	Leave the current scope, undoing every change made to the
+ *		table since entering it.
+ */
+
+void ValueTable::leaveScope()
+{
+    Scope scope = _scopes.back();
+
+
+    _scopes.pop_back();
+
+    while (_numberLog.size() > scope.numbers) {
+	auto &entry = _numberLog.back();
+
+	if (entry.second < 0)
+	    _numbers.erase(entry.first);
+	else
+	    _numbers[entry.first] = entry.second;
+
+	_numberLog.pop_back();
+    }
+
+    while (_exprLog.size() > scope.exprs) {
+	_exprs.erase(_exprLog.back());
+	_exprLog.pop_back();
+    }
+
+    while (_holderLog.size() > scope.holders) {
+	_holders[_holderLog.back().first] = _holderLog.back().second;
+	_holderLog.pop_back();
+    }
+
+    _holders.resize(scope.values);
+}
+
+
+/*
+ * Function:	ValueTable::setNumber (private)
+ *
+ * Description:	Set the value number of the given symbol, logging the old
+ *		value number if we are within a scope.  A negative value
+ *		number removes the symbol from the table.
+ */
+
+void ValueTable::setNumber(Symbol *sym, int value)
+{
+    auto it = _numbers.find(sym);
+    int old = (it != _numbers.end() ? it->second : -1);
+
+
+    if (!_scopes.empty())
+	_numberLog.push_back(make_pair(sym, old));
+
+    if (value < 0) {
+	if (it != _numbers.end())
+	    _numbers.erase(it);
+    } else if (it != _numbers.end())
+	it->second = value;
+    else
+	_numbers.emplace(sym, value);
+}
+
+
+/*
+ * Function:	ValueTable::setHolder (private)
+ *
+ * Description:	Set the holder of the given value number, logging the old
+ *		holder if we are within a scope.
+ */
+
+void ValueTable::setHolder(int value, Symbol *sym)
+{
+    if (!_scopes.empty())
+	_holderLog.push_back(make_pair(value, _holders[value]));
+
+    _holders[value] = sym;
+}
+
+
+/*
+ * Function:	ValueTable::number
+ *
+ * Description:	Return the value number of the given symbol, giving it a
+ *		new value number if it does not yet have one.
+ */
+
+int ValueTable::number(Symbol *sym)
+{
+    auto it = _numbers.find(sym);
+
+    if (it != _numbers.end())
+	return it->second;
+
+    _holders.push_back(sym);
+    setNumber(sym, _holders.size() - 1);
+    return _holders.size() - 1;
+}
+
+
+/*
+ * Function:	ValueTable::number
+ *
+ * Description:	Return the value number of the given expression, giving
+ *		it a new value number if it has not yet been seen.  A unary
+ *		expression has no right operand.
+ */
+
+int ValueTable::number(int op, int left, int right)
+{
+    LVN_expr expr;
+
+
+    if (right >= 0 && left > right) {
+	if (op == AND || op == OR)
+	    swap(left, right);
+	else {
+	    auto dual = duals.find(op);
+
+	    if (dual != duals.end()) {
+		swap(left, right);
+		op = dual->second;
+	    }
+	}
+    }
+
+    expr.op = op;
+    expr.left = left;
+    expr.right = right;
+
+    auto it = _exprs.find(expr);
+
+    if (it != _exprs.end())
+	return it->second;
+
+    if (!_scopes.empty())
+	_exprLog.push_back(expr);
+
+    _holders.push_back(nullptr);
+    return _exprs[expr] = _holders.size() - 1;
+}
+
+
+/*
+ * Function:	ValueTable::holder
+ *
+ * Description:	Return a symbol that currently holds the given value
+ *		number, or null if there is none.
+ */
+
+Symbol *ValueTable::holder(int value) const
+{
+    Symbol *sym = _holders[value];
+
+    if (sym != nullptr) {
+	auto it = _numbers.find(sym);
+
+	if (it != _numbers.end() && it->second == value)
+	    return sym;
+    }
+
+    return nullptr;
+}
+
+
+/*
+ * Function:	ValueTable::assign
+ *
+ * Description:	Record that the given symbol now holds the given value
+ *		number.
+ */
+
+void ValueTable::assign(Symbol *sym, int value)
+{
+    setNumber(sym, value);
+
+    if (holder(value) == nullptr)
+	setHolder(value, sym);
+}
+
+
+/*
+ * Function:	ValueTable::kill
+ *
+ * Description:	Record that the given symbol has been assigned an unknown
+ *		value.
+ */
+
+void ValueTable::kill(Symbol *sym)
+{
+    if (_numbers.count(sym) > 0)
+	setNumber(sym, -1);
+}
+
+
+/*
+ * Function:	ValueTable::killGlobals
+ *
+ * Description:	Record that every global variable has been assigned an
+ *		unknown value, as happens across a function call.
+ */
+
+void ValueTable::killGlobals()
+{
+    Symbols globals;
+
+
+    for (auto &entry : _numbers)
+	if (entry.first->kind() == GLOBAL)
+	    globals.push_back(entry.first);
+
+    for (auto sym : globals)
+	setNumber(sym, -1);
+}
@@ -1,14 +1,75 @@
+/*
+ * File:	lvn.h
+ *
+ * Description:	This file contains the class definition for the value
+ *		table used by local value numbering.
+ *
+ *		Each symbol is mapped to its current value number, and each
+ *		expression, written as its operator and the value numbers
+ *		of its operands, is mapped to the value number it computes.
+ *		The operands of commutative operators, and of relational
+ *		operators which have a dual, are put in canonical order, so
+ *		that "a + b" and "b + a" or "a < b" and "b > a" are given
+ *		the same value number.  Finally, for each value number we
+ *		remember a symbol that holds it, so that a redundant
+ *		expression can be replaced with a copy of that symbol.
+ *
+ *		For global value numbering, the table may also be scoped:
+ *		every change made after entering a scope is undone upon
+ *		leaving it, so that the table can follow a walk of the
+ *		dominator tree without being copied at each block.
+ */
+
 # ifndef LVN_H
 # define LVN_H
+# include <vector>
+# include <utility>
+# include <unordered_map>
+# include "Symbol.h"
 
 struct LVN_expr {
-    //Symbol *left, *right;
-	int left, right, op;
+    int op, left, right;
+
+    bool operator ==(const LVN_expr &e) const {
+	return op == e.op && left == e.left && right == e.right;
+    }
+};
+
+struct lvn_hash {
+    std::size_t operator()(const LVN_expr &expr) const {
+	return std::hash<int>()((expr.op * 31 + expr.left) * 31 + expr.right);
+    }
+};
+
+class ValueTable {
+    std::unordered_map<Symbol *, int> _numbers;
+    std::unordered_map<LVN_expr, int, lvn_hash> _exprs;
+    std::vector<Symbol *> _holders;
+
+    struct Scope {
+	unsigned numbers, exprs, holders, values;
+    };
+
+    std::vector<Scope> _scopes;
+    std::vector<std::pair<Symbol *, int>> _numberLog;
+    std::vector<LVN_expr> _exprLog;
+    std::vector<std::pair<int, Symbol *>> _holderLog;
+
+    void setNumber(Symbol *sym, int value);
+    void setHolder(int value, Symbol *sym);
+
+public:
+    void clear();
+    void enterScope();
+    void leaveScope();
+
+    int number(Symbol *sym);
+    int number(int op, int left, int right = -1);
+    Symbol *holder(int value) const;
+
+    void assign(Symbol *sym, int value);
+    void kill(Symbol *sym);
+    void killGlobals();
 };
-extern std::map<Symbol*, int> sym_int;
-extern std::map<struct LVN_expr*, int> expr_int;
-extern Symbols lvn_globals;
-//std::map<Symbol*, int> sym_int;
-//std::map<struct LVN_expr*, int> expr_int;
 
 # endif /* LVN_H */
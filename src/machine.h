@@ -2,14 +2,21 @@
  * File:	machine.h
  *
  * Description:	This file contains the values of various parameters for the
- *		target machine architecture.
+ *		target machine architecture.  Code is generated for either
+ *		the Intel 32-bit processor or, if target64 is set, the
+ *		x86-64 processor using the System V calling convention.
  */
 
+extern int target64;
+
 # define SIZEOF_CHAR 1
 # define SIZEOF_INT 4
-# define SIZEOF_PTR 4
-# define SIZEOF_REG 4
-# define SIZEOF_ARG 4
+# define SIZEOF_PTR (target64 ? 8 : 4)
+# define SIZEOF_REG (target64 ? 8 : 4)
+# define SIZEOF_ARG (target64 ? 8 : 4)
+
+# define frame_pointer (target64 ? "%rbp" : "%ebp")
+# define stack_pointer (target64 ? "%rsp" : "%esp")
 
 # if defined (__linux__) && (defined(__i386__) || defined(__x86_64__))
 
@@ -0,0 +1,96 @@
+/*
+ * File:	modref.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for summarizing the global variables that a
+ *		function may read or write.
+ *
+ *		Once a function has been optimized, the global scalars
+ *		named by its statements are recorded, along with those of
+ *		the functions it calls.  A call then only kills the copies,
+ *		expressions, and values that involve a global its callee
+ *		may write, and only uses the globals its callee may read.
+ *		Arrays are not recorded, since no analysis tracks their
+ *		contents, and one may be written through a parameter.
+ *
+ *		The summary of a function is only known if the summary of
+ *		each function it calls is known, other than itself.  Since
+ *		a function is compiled after the functions it calls, only
+ *		a call to a function defined elsewhere, or to one in the
+ *		same cycle of calls, may read or write any global.
+ */
+
+# include <unordered_set>
+# include "modref.h"
+
+using namespace std;
+
+
+/*
+ * Function:	isGlobal (private)
+ *
+ * Description:	Return whether the given symbol is a global scalar.
+ */
+
+static bool isGlobal(Symbol *sym)
+{
+    return sym != nullptr && sym->kind() == GLOBAL && sym->type().isScalar();
+}
+
+
+/*
+ * Function:	effectsOf
+ *
+ * Description:	Return the summary of the function called by the given
+ *		statement, or null if it is not known.
+ */
+
+const Effects *effectsOf(const Call *call)
+{
+    auto it = functions.find(call->_function);
+
+
+    if (it == functions.end() || !it->second.effects.known)
+	return nullptr;
+
+    return &it->second.effects;
+}
+
+
+/*
+ * Function:	summarizeEffects
+ *
+ * Description:	Summarize the global variables that the given function may
+ *		read or write.
+ */
+
+void summarizeEffects(Function &function)
+{
+    Call *call;
+    const Effects *callee;
+    unordered_set<Symbol *> reads, writes;
+
+
+    for (auto stmt : function.stmts) {
+	call = dynamic_cast<Call *>(stmt);
+
+	if (call != nullptr && call->_function != function.symbol) {
+	    if ((callee = effectsOf(call)) == nullptr)
+		return;
+
+	    reads.insert(callee->reads.begin(), callee->reads.end());
+	    writes.insert(callee->writes.begin(), callee->writes.end());
+	}
+
+	if (isGlobal(stmt->result()))
+	    writes.insert(stmt->result());
+
+	for (unsigned i = 0; i < stmt->uses(); i ++)
+	    if (isGlobal(stmt->use(i)))
+		reads.insert(stmt->use(i));
+    }
+
+    function.effects.reads.assign(reads.begin(), reads.end());
+    function.effects.writes.assign(writes.begin(), writes.end());
+    function.effects.known = true;
+}
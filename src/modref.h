@@ -0,0 +1,16 @@
+/*
+ * File:	modref.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		summarizing the global variables that a function may read
+ *		or write.
+ */
+
+# ifndef MODREF_H
+# define MODREF_H
+# include "Function.h"
+
+void summarizeEffects(Function &function);
+const Effects *effectsOf(const Call *call);
+
+# endif /* MODREF_H */
@@ -7,6 +7,16 @@ extern int cfold_on = 0;*/
 extern int dce_on;
 extern int cprop_on ;
 extern int lvn_on ;
+extern int gvn_on ;
 extern int asimp_on ;
 extern int cfold_on ;
+extern int sccp_on ;
+extern int cse_on ;
+extern int licm_on ;
+extern int ivsr_on ;
+extern int ssa_on ;
+extern int inline_on ;
+extern int tailcall_on ;
+extern int peephole_on ;
+extern int stats_on ;
 
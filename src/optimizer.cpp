@@ -20,19 +20,29 @@
 # include "lvn.h"
 # include "dataflow.h"
 # include "opflgs.h"
+# include "solver.h"
+# include "translator.h"
+# include "stats.h"
+# include "loops.h"
+# include "sccp.h"
+# include "ssa.h"
+# include "inliner.h"
+# include "tailcall.h"
+# include "modref.h"
 
 # define DCE     dce_on
 # define ALGSIMP asimp_on
 # define CF      cfold_on
+# define SCCP    sccp_on
 # define LVN     lvn_on
+# define GVN     gvn_on
 # define CPROP	 cprop_on
-# define CSE     0
-/*
-typedef struct LVA_sets {
-    std::unordered_set<Symbol *> gen;
-    std::unordered_set<Symbol *> kill;
-} LVA_sets;
-*/
+# define CSE     cse_on
+# define LICM    licm_on
+# define IVSR    ivsr_on
+# define SSA     ssa_on
+# define INLINE  inline_on
+# define TAILCALL tailcall_on
 
 using namespace std;
 
@@ -41,23 +51,15 @@ using namespace std;
 void initLVA(Block *b, Function &function);
 void doLVA(Function &function);
 bool doDCE(Function &function);
-map<Block*, int> dce_marks;
-int marked = 1;
+thread_local map<Block*, int> dce_marks;
+thread_local int marked = 1;
 void doDFS(Block *block);
 bool doConstantFolding(Function &function);
 bool doAlgSimp(Function &function);
 bool doLVN(Function &function);
+bool doGVN(Function &function);
 bool doCprop(Function &function);
-Symbols lvn_globals;
 bool doCSE(Function &function);
-//std::map<Symbol*, int> sym_int;
-//std::map<struct LVN_expr*, int> expr_int;
-/*
-struct LVN_expr {
-	Symbol *left, *right;
-	int op;
-};
-*/
 
 template< class Iterator >
 reverse_iterator<Iterator> make_reverse_iterator(Iterator i)
@@ -70,129 +72,218 @@ void optimizeTree(Function &function)
 	
 }
 
-void optimizeStatements(Function &function)
+// run the passes until none of them changes anything; the loop passes
+// rebuild the flowgraph, so they are left out while in SSA form
+void optimizeRounds(Function &function, bool ssa)
 {
-	rebuildFlowgraph(function);
-
 	bool changed = true;
 	while(changed) {
 		changed = false;
+		function.stats.rounds ++;
 		//cout << "# optimize\n";
-		doLVA(function);
+		runPass(function, "lva", [](Function &f) { doLVA(f); return false; });
 		//cout << "# did lva\n";
 		if(DCE)
-			if(doDCE(function)) {
+			if(runPass(function, "dce", doDCE)) {
 				changed = true;
 				//cout << "# dce changed\n";
-				rebuildFlowgraph(function);
-				//cout << "# dce rebuilt\n";
 			}
 		if(ALGSIMP)	
-			if(doAlgSimp(function)) {
+			if(runPass(function, "asimp", doAlgSimp)) {
 				changed = true;
-				rebuildFlowgraph(function);
 			}
 		if(CF)
-			if(doConstantFolding(function)) {
+			if(runPass(function, "cfold", doConstantFolding)) {
+				changed = true;
+			}
+		if(SCCP)
+			if(runPass(function, "sccp", propagateConstants)) {
 				changed = true;
-				rebuildFlowgraph(function);
 			}
 		if(LVN)
-			if(doLVN(function)) {
+			if(runPass(function, "lvn", doLVN)) {
+				changed = true;
+			}
+		if(GVN)
+			if(runPass(function, "gvn", doGVN)) {
+				changed = true;
+			}
+		if(CPROP && ssa)
+			if(runPass(function, "ssacp", propagateCopies)) {
 				changed = true;
-				rebuildFlowgraph(function);
 			}
 		if(CPROP)
-			if(doCprop(function)) {
+			if(runPass(function, "cprop", doCprop)) {
 				changed = true;
-				rebuildFlowgraph(function);
 			}
 		if(CSE)
-			if(doCSE(function)) {
+			if(runPass(function, "cse", doCSE)) {
+				changed = true;
+			}
+		if(LICM && !ssa)
+			if(runPass(function, "licm", hoistInvariants)) {
+				changed = true;
+			}
+		if(IVSR && !ssa)
+			if(runPass(function, "ivsr", reduceInductions)) {
 				changed = true;
-				rebuildFlowgraph(function);
 			}
 	}
 }
-expr_set uni;
-struct cse_uni cse_universe;
 
-void AvailExprsinit(Block *block, Function &function) {
-	block->ExprKill.clear();
-	block->DEExprs.clear();
-	struct avail_expr gen_kill;
-	struct avail_expr temp;
-	for(auto it = function.stmts.begin(); it != function.stmts.end(); it++) {
-		(*it)->gen_cse_uni(cse_universe);
+void optimizeStatements(Function &function)
+{
+	Timer timer(function.stats.phases[OPTIMIZATION]);
+	function.stats.before = function.stmts.size();
+	rebuildFlowgraph(function);
+
+	// the callees have already been optimized, and what we inline is
+	// optimized again here along with the rest of the function
+	if(INLINE)
+		runPass(function, "inline", inlineCalls);
+
+	// tail recursion becomes a loop before the loop passes run
+	if(TAILCALL)
+		runPass(function, "tailcall", eliminateTailCalls);
+
+	// the scalar passes first see the function in SSA form, and then
+	// again once the phis have been replaced by copies
+	if(SSA) {
+		runPass(function, "ssa", buildSSA);
+		optimizeRounds(function, true);
+		runPass(function, "unssa", destroySSA);
 	}
+	optimizeRounds(function, false);
+
+	// the passes keep the flowgraph up to date, so we only need to
+	// rebuild it once to clean up any labels left behind
+	rebuildFlowgraph(function);
+	function.stats.after = function.stmts.size();
+
+	if(INLINE)
+		saveForInlining(function);
+	summarizeEffects(function);
+}
+thread_local expr_universe cse_universe;
+thread_local expr_set cse_call_kills;
+
+void AvailExprsinit(Block *block, Function &function) {
+	block->ExprKill = expr_set(cse_universe.size());
+	block->DEExprs = expr_set(cse_universe.size());
 	for(auto it = block->begin(); it != block->end(); it++) {
-		temp = (*it)->availExpr(cse_universe);
-		for(auto &killed : temp.kill) {
-			block->ExprKill.insert(killed);
-			block->DEExprs.erase(killed);
-		}
-		for(auto &genned : temp.gen) {
-			block->DEExprs.insert(genned);
-		}
+		(*it)->availExpr(block->DEExprs, block->ExprKill, cse_universe, cse_call_kills);
 	}
 }
 
 void doAvailExprs(Function &function) {
 	
 	Blocks blocks = getBlocks(function);
-	bool changed = true;
-	while(changed) {
-		changed = false;
-		for(auto &block : blocks) {
-			block->ExprKill.clear();
-			block->DEExprs.clear();
-			AvailExprsinit(block, function);
-			block->AvailIn = cse_universe.uni;
-			auto atemp = block->AvailIn;
-			auto temp = cse_universe.uni;
-			for(auto &pred : block->predecessors()) {
-				auto avail_inp = pred->AvailIn;
-				auto killp = pred->ExprKill;
-				auto genp = pred->DEExprs;
-			
-				remove(avail_inp, killp);
-				insert(genp, avail_inp);
-				filter(temp, genp);
-				block->AvailIn = temp;
-			}
-			changed = changed || atemp != block->AvailIn;
+
+	// create the universe
+	cse_universe.clear();
+	for(auto stmt : function.stmts) {
+		stmt->gen_cse_uni(cse_universe);
+	}
+	cse_universe.index();
+
+	// a call kills every expression involving a global variable
+	cse_call_kills = expr_set(cse_universe.size());
+	for(auto &glob : function.locals->enclosing()->symbols()) {
+		if((glob->kind() == GLOBAL) && !((glob->type().isFunction()))){
+			cse_call_kills |= cse_universe.killed(glob);
 		}
 	}
+
+	for(auto &block : blocks) {
+		AvailExprsinit(block, function);
+	}
+
+	solve(function, FORWARD, cse_universe.size(), expr_set(cse_universe.size()),
+		Intersection(),
+		[](Block *block, const expr_set &in, expr_set &out) {
+			remove(out, block->ExprKill);
+			insert(out, block->DEExprs);
+		},
+		[](Block *block) -> expr_set & { return block->AvailIn; });
 }
 
 
+/*
+ * A binary statement is redundant if its expression is available before
+ * it.  Every evaluation of an expression that is redundant somewhere is
+ * rewritten to save its value in a temporary, and each redundant
+ * statement then becomes a copy of that temporary.  Since the
+ * expression is available, the temporary holds its value along every
+ * path.  Copy propagation and dead code elimination clean up the rest.
+ */
 bool doCSE(Function &function) {
-	cout << "# doCSE\n";
 	bool changed = false;
 	Blocks blocks = getBlocks(function);
-	
+	expr_set avail, kill, redundant;
+	vector<Symbol *> temps;
+	Binary *binary;
+	int expr;
+
 	doAvailExprs(function);
-	
+	kill = expr_set(cse_universe.size());
+
+	// find the expressions that are redundant somewhere
+	redundant = expr_set(cse_universe.size());
 	for(auto &block : blocks) {
-		block->DEExprs.clear();
-		block->ExprKill.clear();
-		block->DEExprs = block->AvailIn;
+		avail = block->AvailIn;
+		for(auto it = block->begin(); it != block->end(); it++) {
+			if((binary = dynamic_cast<Binary *>(*it)) != nullptr) {
+				expr = cse_universe.find(expr_tuple{binary->_left, binary->_right, binary->_token});
+				if(expr >= 0 && avail.test(expr))
+					redundant.set(expr);
+			}
+			(*it)->availExpr(avail, kill, cse_universe, cse_call_kills);
+		}
 	}
-	
-	avail_expr temp;
-	
-	
+
+	if(redundant.empty())
+		return false;
+
+	temps.resize(cse_universe.size(), nullptr);
+	for(unsigned i = redundant.first(); i < redundant.size(); i = redundant.next(i))
+		temps[i] = makeTemp();
+
+	// save each evaluation and replace each redundant one
+	for(auto &block : blocks) {
+		avail = block->AvailIn;
+		auto it = block->begin();
+		while(it != block->end()) {
+			expr = -1;
+			if((binary = dynamic_cast<Binary *>(*it)) != nullptr)
+				expr = cse_universe.find(expr_tuple{binary->_left, binary->_right, binary->_token});
+
+			bool available = expr >= 0 && avail.test(expr);
+			(*it)->availExpr(avail, kill, cse_universe, cse_call_kills);
+
+			if(expr >= 0 && temps[expr] != nullptr) {
+				if(!available)
+					insertStatement(function, block, it, new Binary(binary->_token, temps[expr], binary->_left, binary->_right));
+				it = replaceStatement(function, block, it, new Copy(binary->_result, temps[expr]));
+				changed = true;
+			}
+			it++;
+		}
+	}
+
 	return changed;
 }
 
-map<Block*,copy_set> DECopies;
-map<Block*,copy_set> CopyKill;
-map<Block*,copy_set> AvailIn;
-copy_set universe;
+thread_local map<Block*,copy_set> DECopies;
+thread_local map<Block*,copy_set> CopyKill;
+thread_local map<Block*,copy_set> AvailIn;
+thread_local copy_universe universe;
+thread_local copy_set call_kills;
 	
-void availCopiesInit(Block *block, Symbols &globals) {
+void availCopiesInit(Block *block) {
+	DECopies[block] = copy_set(universe.size());
+	CopyKill[block] = copy_set(universe.size());
 	for(auto it = block->begin(); it != block->end(); it++) {
-		(*it)->cp_gen_kill(DECopies[block], CopyKill[block], universe, globals);
+		(*it)->cp_gen_kill(DECopies[block], CopyKill[block], universe, call_kills);
 	}	
 }
 
@@ -201,61 +292,31 @@ void doAvailCopies(Function &function) {
 	Blocks blocks = getBlocks(function);
 
 	// create the universe
+	universe.clear();
 	for(auto stmt : function.stmts) {
 		stmt->cp_uni(universe);
 	}
-	
-	auto globals = 	function.locals->enclosing()->symbols();
-	for(auto &block : blocks) {
-		availCopiesInit(block, globals);
-		AvailIn[block] = universe;
+	universe.index();
+
+	// a call kills every copy involving a global variable
+	call_kills = copy_set(universe.size());
+	for(auto &glob : function.locals->enclosing()->symbols()) {
+		if((glob->kind() == GLOBAL) && !((glob->type().isFunction()))){
+			call_kills |= universe.killed(glob);
+		}
 	}
-	AvailIn[function.entry].clear();
-	
-				/*cout << "universe\n";
-				for(auto &pair : universe) {
-                    cout << pair.first->name() << ", " << pair.second->name() << endl;
-	
-				}  */
-	bool changed = true;
-	while(changed) {
-		changed = false;
-		for(auto &block : blocks) {
-			auto temp = AvailIn[block];
-			auto check = AvailIn[block];
-			AvailIn[block].clear();
-			copy_set outp; 
-			for(auto &pred : block->predecessors()) {
-				auto inp = AvailIn[pred];
-				auto killp = CopyKill[pred];
-				auto genp = DECopies[pred];
-				remove(inp, killp);
-				insert(genp, inp);
-				outp = genp;
-				/*cout << "outp\n";
-				for(auto &pair : outp) {
-                    cout << pair.first->name() << ", " << pair.second->name() << endl;
 	
-				}*/
-				filter(temp, outp);
-				/*cout << "temp\n";
-				for(auto &pair : temp) {
-                    cout << pair.first->name() << ", " << pair.second->name() << endl;
-	
-				}*/
-			}
-			AvailIn[block] = temp;
-		/*cout << "# DECopies\n";
-		for(auto &pair : DECopies[block]) {
-			cout << pair.first->name() << ", " << pair.second->name() << endl;
-		}
-		cout << "# AvailIn\n";
-		for(auto &pair : AvailIn[block]) {
-			cout << pair.first->name() << ", " << pair.second->name() << endl;
-		}*/
-			changed = changed || check != AvailIn[block];
-		}
+	for(auto &block : blocks) {
+		availCopiesInit(block);
 	}
+
+	solve(function, FORWARD, universe.size(), copy_set(universe.size()),
+		Intersection(),
+		[](Block *block, const copy_set &in, copy_set &out) {
+			remove(out, CopyKill[block]);
+			insert(out, DECopies[block]);
+		},
+		[](Block *block) -> copy_set & { return AvailIn[block]; });
 }
 
 bool doCprop(Function &function) {
@@ -263,26 +324,12 @@ bool doCprop(Function &function) {
 	bool changed = false;
 	doAvailCopies(function);
 	Blocks blocks = getBlocks(function);
-	auto globals = 	function.locals->enclosing()->symbols();
 	for(auto &block : blocks) {
 		CopyKill[block].clear();
-		DECopies[block].clear();
-		insert(DECopies[block], AvailIn[block]);
-		/*cout << "DECopies\n";
-		for(auto &pair : DECopies[block]) {
-			cout << pair.first->name() << ", " << pair.second->name() << endl;
-		}
-		cout << "AvailIn\n";
-		for(auto &pair : AvailIn[block]) {
-			cout << pair.first->name() << ", " << pair.second->name() << endl;
-		} */
+		DECopies[block] = AvailIn[block];
 		for(auto it = block->begin(); it != block->end(); it++) {
-			(*it)->cp_gen_kill(DECopies[block], CopyKill[block], universe, globals);
-			changed = changed || (*it)->cprop(DECopies[block], CopyKill[block], AvailIn[block], universe);
-
-			for(auto stmt : function.stmts) {
-		        stmt->cp_uni(universe);
-			}
+			(*it)->cp_gen_kill(DECopies[block], CopyKill[block], universe, call_kills);
+			changed = (*it)->cprop(DECopies[block], CopyKill[block], AvailIn[block], universe) || changed;
 		}
 
 	}
@@ -291,129 +338,237 @@ bool doCprop(Function &function) {
 }
 
 bool doLVN(Function &function) {
-	//cout << sym_int.size() << endl;
-	//cout << expr_int.size() << endl;
-	sym_int.clear();
-	expr_int.clear();
-	lvn_globals = function.locals->enclosing()->symbols();
-	int val_num = 0;
-	//cout << "# doLVN\n";
+	ValueTable table;
 	bool changed = false;
 	Statement *result;
-	auto it = function.stmts.begin();
-		
-	while (it != function.stmts.end()) {
-		//cout << "# while\n";
-		result = (*it)->valnum(val_num);
+
+	for(auto &block : getBlocks(function)) {
+		auto it = block->begin();
+
+		// value numbers are only valid within a single block
+		table.clear();
+
+		while (it != block->end()) {
+			result = (*it)->valnum(table);
+			if (result == nullptr) {
+				it = eraseStatement(function, block, it);
+				changed = true;
+			} else {
+				if (result != *it) {
+					it = replaceStatement(function, block, it, result);
+					changed = true;
+				} 
+				it++;
+			}
+		}
+	}
+	return changed;
+}
+
+// the symbols assigned in a block, and whether it calls a function
+struct BlockDefs {
+	Symbols symbols;
+	bool calls = false;
+};
+
+typedef unordered_map<Block *, BlockDefs> gvn_defs;
+
+/*
+ * On entering a block, forget the value of any symbol that may have been
+ * assigned along a path from its immediate dominator, since the table
+ * only describes the end of the dominator.  These paths run through the
+ * blocks that reach the block without passing through its dominator.
+ */
+void gvnKill(Block *block, ValueTable &table, gvn_defs &defs) {
+	Blocks work;
+	unordered_set<Block *> seen;
+	bool calls = false;
+
+	for(auto &pred : block->predecessors())
+		if(pred != block->idom() && seen.insert(pred).second)
+			work.push_back(pred);
+
+	while(!work.empty()) {
+		Block *b = work.back();
+		work.pop_back();
+
+		for(auto &sym : defs[b].symbols)
+			table.kill(sym);
+		calls = calls || defs[b].calls;
+
+		for(auto &pred : b->predecessors())
+			if(pred != block->idom() && seen.insert(pred).second)
+				work.push_back(pred);
+	}
+
+	if(calls)
+		table.killGlobals();
+}
+
+bool gvnBlock(Function &function, Block *block, ValueTable &table, gvn_defs &defs) {
+	bool changed = false;
+	Statement *result;
+
+	table.enterScope();
+	gvnKill(block, table, defs);
+
+	auto it = block->begin();
+	while (it != block->end()) {
+		result = (*it)->valnum(table);
 		if (result == nullptr) {
-			delete *it;
-			//cout << "result == nullptr\n";
-			it = function.stmts.erase(it);
-			//changed = true;
+			it = eraseStatement(function, block, it);
+			changed = true;
 		} else {
 			if (result != *it) {
-				delete *it;
-				//cout << "result != *it\n";
-				*it = result;
+				it = replaceStatement(function, block, it, result);
 				changed = true;
-			} 
+			}
 			it++;
-			//cout << "# it++\n";
 		}
 	}
+
+	for(auto &child : block->dominated())
+		changed = gvnBlock(function, child, table, defs) || changed;
+
+	table.leaveScope();
 	return changed;
 }
 
+// value numbering over the dominator tree, so that an expression is
+// replaced if it is already held by a symbol in a dominating block
+bool doGVN(Function &function) {
+	ValueTable table;
+	gvn_defs defs;
+
+	computeDominators(function);
+
+	for(auto &block : getBlocks(function))
+		for(auto it = block->begin(); it != block->end(); it++) {
+			if((*it)->result() != nullptr)
+				defs[block].symbols.push_back((*it)->result());
+			if(Call *call = dynamic_cast<Call *>(*it)) {
+				// a call only assigns the globals it is known to
+				const Effects *effects = effectsOf(call);
+				if(effects == nullptr)
+					defs[block].calls = true;
+				else
+					for(auto sym : effects->writes)
+						defs[block].symbols.push_back(sym);
+			}
+		}
+
+	return gvnBlock(function, function.entry, table, defs);
+}
+
+thread_local sym_universe variables;
+thread_local sym_set live_globals;
+
 void doLVA(Function &function) {
 	//cout << "# doLVA\n";
 	Blocks blocks = getBlocks(function);
-	bool changed = true;
 
-	for(auto &block : blocks) {
-		initLVA(block, function);
-		block->_LiveOut.clear(); 
-	}	
+	// number every variable that is used or defined
+	variables.clear();
 	for(auto &glob : function.locals->enclosing()->symbols()) {
 		if((glob->kind() == GLOBAL) && !((glob->type().isFunction()))){
-			//cout << "#LiveOut.insert(glob) \n";
-			function.exit->_LiveOut.insert(glob);
+			variables.insert(glob);
+		}
+	}
+	for(auto stmt : function.stmts) {
+		if(stmt->result() != nullptr)
+			variables.insert(stmt->result());
+		for(unsigned i = 0; i < stmt->uses(); i++) {
+			if(!isLiteral(stmt->use(i)))
+				variables.insert(stmt->use(i));
 		}
 	}
 
-	//cout << "left for\n";
-			
-	// for each block in the function
-	while(changed) {
-		changed = false;
-		blocks = getBlocks(function);
-		//for(auto &block : blocks) {
-		for(auto blocki = blocks.rbegin(); blocki != blocks.rend(); blocki++) {
-			// for each succ
-			auto block = *blocki;
-			for(auto &succ : block->successors()) {
-				// insert UEVar(succ)
-				auto temp = block->_LiveOut;
-				for(auto &uevar : succ->_UEVar) {
-					block->_LiveOut.insert(uevar);
-					//cout << "c1\n";
-				}
-
-				// insert LiveOut(succ) - VarKill(succ)
-				for(auto &lk : succ->_LiveOut) {
-					if(succ->_VarKill.count(lk) == 0) {
-						block->_LiveOut.insert(lk);
-						//cout << "c2\n";
-					}
-				}
-				changed = temp != block->_LiveOut;
-			}
+	live_globals = sym_set(variables.size());
+	for(auto &glob : function.locals->enclosing()->symbols()) {
+		if((glob->kind() == GLOBAL) && !((glob->type().isFunction()))){
+			live_globals.set(variables.find(glob));
 		}
-	} 
-	/*
-	int i = 0;
-	for (auto &block : getBlocks(function)){
-        cerr << "# block" << i << endl; i++;
-        cerr << "# UEVAR" << endl;
-        for(auto i : block->_UEVar)
-            cerr << "\t" << i->name() << endl;
-        cerr << "# Varkill" << endl;
-        for(auto i : block->_VarKill)
-            cerr << "\t" << i->name() << endl;
-        cerr << "# LiveOut" << endl;
-        for(auto i : block->_LiveOut)
-            cerr << "\t" << i->name() << endl;
-    } */ 
-	
+	}
+
+	for(auto &block : blocks) {
+		initLVA(block, function);
+	}	
+
+	solve(function, BACKWARD, variables.size(), live_globals, Union(),
+		[](Block *block, const sym_set &in, sym_set &out) {
+			remove(out, block->_VarKill);
+			insert(out, block->_UEVar);
+		},
+		[](Block *block) -> sym_set & { return block->_LiveOut; });
+}
 
+// whether a symbol is live on entry to or exit from a block, according to
+// the last call to doLVA
+bool isLiveIn(Block *block, Symbol *sym) {
+	int var = variables.find(sym);
+	if(var < 0)
+		return false;
+	return block->_UEVar.test(var) || (block->_LiveOut.test(var) && !block->_VarKill.test(var));
+}
+
+bool isLiveOut(Block *block, Symbol *sym) {
+	int var = variables.find(sym);
+	return var >= 0 && block->_LiveOut.test(var);
+}
+
+Symbols liveIn(Block *block) {
+	Symbols symbols;
+	sym_set live = block->_LiveOut;
+	remove(live, block->_VarKill);
+	insert(live, block->_UEVar);
+	for(unsigned i = live.first(); i < live.size(); i = live.next(i))
+		symbols.push_back(variables[i]);
+	return symbols;
+}
+
+Symbols liveOut(Block *block) {
+	Symbols symbols;
+	const sym_set &live = block->_LiveOut;
+	for(unsigned i = live.first(); i < live.size(); i = live.next(i))
+		symbols.push_back(variables[i]);
+	return symbols;
+}
+
+// a call uses the globals it is known to read, or else all of them
+void useGlobals(sym_set &live, Statement *stmt) {
+	Call *call = dynamic_cast<Call *>(stmt);
+	if(call == nullptr)
+		return;
+	const Effects *effects = effectsOf(call);
+	if(effects == nullptr)
+		insert(live, live_globals);
+	else
+		for(auto sym : effects->reads)
+			if(variables.find(sym) >= 0)
+				live.set(variables.find(sym));
 }
 
 void initLVA(Block *block, Function &function) {
 	//cout << "# initLVA\n";
-	block->_UEVar.clear();
-	block->_VarKill.clear();
+	block->_UEVar = sym_set(variables.size());
+	block->_VarKill = sym_set(variables.size());
 	// for each statement in the block
 	for(auto it = (block->rbegin()); it != (block->rend()); it++) {
 		
-		auto sets = (*it)->make_lva_sets();
-		if((sets.kill != nullptr) && (1 || !isNumber(sets.kill))) {
-			//cout << "# set kill: " << sets.kill->name() << endl;
-			block->_VarKill.insert(sets.kill);
-			block->_UEVar.erase(sets.kill);
+		Statement *stmt = *it;
+		if(stmt->result() != nullptr) {
+			int kill = variables.find(stmt->result());
+			block->_VarKill.set(kill);
+			block->_UEVar.reset(kill);
 		}
 
 		// insert gen elements
-		for(auto &genned : sets.gen) {
-			if(!isNumber(genned))
-				block->_UEVar.insert(genned);
+		for(unsigned i = 0; i < stmt->uses(); i++) {
+			if(!isLiteral(stmt->use(i)))
+				block->_UEVar.set(variables.find(stmt->use(i)));
 		}
 
-		if(sets.isFunc == 1){
-			for(auto &glob : function.locals->enclosing()->symbols()) {
-				if((glob->kind() == GLOBAL) && !((glob->type().isFunction()))){
-					block->_UEVar.insert(glob);
-				}
-			}
-		}
+		useGlobals(block->_UEVar, stmt);
 	}
 }
 
@@ -429,41 +584,32 @@ bool doDCE(Function &function) {
 		block->_UEVar = block->_LiveOut;
 		// walk each block backwards
 		while(it != block->rend()) {
-			auto set = (*it)->make_lva_sets();
-			
-			/*
-			if(set.isFunc == 1) {
-				for(auto &glob : function.locals->enclosing()->symbols()) {
-					if((glob->kind() == GLOBAL) && !((glob->type().isFunction()))){
-						block->_UEVar.insert(glob);
-					}
-				}
-			} */ 
-
-			if((set.kill != nullptr) && (block->_UEVar.count(set.kill) == 0)) {
-				delete *it;
-				it = make_reverse_iterator(function.stmts.erase(find(function.stmts.begin(), function.stmts.end(),*it)));
-				changed = true;
-			} else {
-				it++;
-			}
+			Statement *stmt = *it;
+			int kill = (stmt->result() != nullptr ? variables.find(stmt->result()) : -1);
+			bool dead = (kill >= 0) && !block->_UEVar.test(kill);
 	
-			if((set.kill != nullptr) && (1 || !isNumber(set.kill))) {
-				block->_VarKill.insert(set.kill);
-				block->_UEVar.erase(set.kill);
+			if(kill >= 0) {
+				block->_VarKill.set(kill);
+				block->_UEVar.reset(kill);
 			}
 
 			// insert gen elements
-			for(auto &genned : set.gen) {
-				if(!isNumber(genned))
-					block->_UEVar.insert(genned);
+			for(unsigned i = 0; i < stmt->uses(); i++) {
+				if(!isLiteral(stmt->use(i)))
+					block->_UEVar.set(variables.find(stmt->use(i)));
+			}
+			useGlobals(block->_UEVar, stmt);
+
+			// the statement is only read above, since erasing deletes it
+			if(dead) {
+				it = make_reverse_iterator(eraseStatement(function, block, prev(it.base())));
+				changed = true;
+			} else {
+				it++;
 			}
 		}
 	}
 
-	if(changed)
-		rebuildFlowgraph(function);
-
 	//changed = false;
 	// eliminate unreachable code
 	// mark all blocks as not found
@@ -477,11 +623,10 @@ bool doDCE(Function &function) {
 	doDFS(it);
 	//cout << "# DoDFS\n";
 	for(auto &block : blocks) {
-		if (dce_marks[block] == 0) {
+		if (dce_marks[block] == 0 && block->begin() != block->end()) {
 			// delete block by deleting all stmts in block
 			for(auto stit = block->begin(); stit != block->end();) {
-				delete *stit;
-				stit = function.stmts.erase(stit);
+				stit = eraseStatement(function, block, stit);
 			}
 			changed = true;
 		//	cout << "#deleted stmt\n";
@@ -508,21 +653,21 @@ bool doConstantFolding(Function &function) {
 	//cout << "# doCF\n";
 	bool changed = false;
     Statement *result;
-    auto it = function.stmts.begin();
-    while (it != function.stmts.end()) {
-        result = (*it)->cfold();
-        if (result == nullptr) {
-            delete *it;
-            it = function.stmts.erase(it);
-            changed = true;
-        } else {
-            if (result != *it) {
-                delete *it;
-                //cout << "result != *it\n";
-                *it = result;
+    for(auto &block : getBlocks(function)) {
+        auto it = block->begin();
+        while (it != block->end()) {
+            result = (*it)->cfold();
+            if (result == nullptr) {
+                it = eraseStatement(function, block, it);
                 changed = true;
+            } else {
+                if (result != *it) {
+                    //cout << "result != *it\n";
+                    it = replaceStatement(function, block, it, result);
+                    changed = true;
+                }
+                it++;
             }
-            it++;
         }
     }
 
@@ -534,23 +679,22 @@ bool doAlgSimp(Function &function) {
 	//cout << "# doAlgSimp\n";
 	bool changed = false;
 	Statement *result;
-	auto it = function.stmts.begin();
-	while (it != function.stmts.end()) {
-		//changed = false;
-		result = (*it)->simplify();
-		if (result == nullptr) {
-			delete *it;
-			cout << "result == nullptr\n";
-			it = function.stmts.erase(it);
-			changed = true;
-		} else {
-			if (result != *it) {
-				delete *it;
-				//cout << "result != *it\n";
-				*it = result;
+	for(auto &block : getBlocks(function)) {
+		auto it = block->begin();
+		while (it != block->end()) {
+			//changed = false;
+			result = (*it)->simplify();
+			if (result == nullptr) {
+				it = eraseStatement(function, block, it);
 				changed = true;
-			} 
-			it++;
+			} else {
+				if (result != *it) {
+					//cout << "result != *it\n";
+					it = replaceStatement(function, block, it, result);
+					changed = true;
+				} 
+				it++;
+			}
 		}
 	}
 
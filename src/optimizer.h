@@ -13,4 +13,10 @@
 void optimizeTree(Function &function);
 void optimizeStatements(Function &function);
 
+void doLVA(Function &function);
+bool isLiveIn(Block *block, Symbol *sym);
+bool isLiveOut(Block *block, Symbol *sym);
+Symbols liveIn(Block *block);
+Symbols liveOut(Block *block);
+
 # endif /* OPTIMIZER_H */
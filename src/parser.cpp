@@ -9,7 +9,15 @@
 # include <string>
 # include <cstdio>
 # include <cstdlib>
+# include <thread>
+# include <vector>
+# include <atomic>
+# include <mutex>
+# include <deque>
+# include <condition_variable>
+# include <sstream>
 # include <iostream>
+# include <functional>
 # include "unistd.h"
 # include "Node.h"
 # include "lexer.h"
@@ -18,8 +26,12 @@
 # include "checker.h"
 # include "literal.h"
 # include "generator.h"
+# include "emitter.h"
 # include "optimizer.h"
 # include "translator.h"
+# include "callgraph.h"
+# include "stats.h"
+# include "machine.h"
 # include <getopt.h>
 # include "opflgs.h"
 using namespace std;
@@ -27,8 +39,19 @@ using namespace std;
 int dce_on=0;
 int cprop_on=0;
 int lvn_on=0;
+int gvn_on=0;
 int asimp_on=0;
 int cfold_on = 0;
+int sccp_on = 0;
+int cse_on = 0;
+int licm_on = 0;
+int ivsr_on = 0;
+int ssa_on = 0;
+int inline_on = 0;
+int tailcall_on = 0;
+int peephole_on = 0;
+int stats_on = 0;
+int target64 = 0;
 
 
 
@@ -36,6 +59,9 @@ static int word, peeked;
 static string lexeme;
 static Node *expression(), *statement();
 
+static int jobs = 1;
+static vector<Function> pending;
+
 static enum {
     OUTPUT_ASM, OUTPUT_AST, OUTPUT_TAC,
 } output_format;
@@ -49,8 +75,10 @@ static enum {
 
 static int peek()
 {
-    if (peeked == 0)
+    if (peeked == 0) {
+	Timer timer(phaseTime(LEXING));
 	peeked = yylex();
+    }
 
     return peeked;
 }
@@ -72,8 +100,10 @@ static int nextWord()
     if (peeked != 0) {
 	token = peeked;
 	peeked = 0;
-    } else
+    } else {
+	Timer timer(phaseTime(LEXING));
 	token = yylex();
+    }
 
     lexeme = yytext;
     return token;
@@ -894,6 +924,7 @@ static void globalDeclaration()
     string name;
     Types *formals;
     Function function;
+    Timer parsing(phaseTime(PARSING));
     
     
     typespec = specifier();
@@ -921,23 +952,41 @@ static void globalDeclaration()
 	function.body = statements();
 	match('}');
 	finalizeScope();
+	parsing.stop();
 
 	if (numerrors == 0) {
+	    function.arena = new Arena();
+	    Arena::current(function.arena);
 	    optimizeTree(function);
 
+	    if (output_format != OUTPUT_AST && jobs > 1) {
+		Arena::current(nullptr);
+		pending.push_back(std::move(function));
+		return;
+	    }
+
 	    if (output_format == OUTPUT_AST)
-		cout << function.body << endl;
+		output << function.body << '\n';
 	    else {
+		Timer translation(function.stats.phases[TRANSLATION]);
 		function.stmts = translate(function.body);
+		translation.stop();
+
 		optimizeStatements(function);
 
 		if (output_format == OUTPUT_TAC)
-		    cout << function.stmts << endl;
+		    output << function.stmts << '\n';
 		else if (output_format == OUTPUT_ASM)
 		    generateFunction(function);
+
+		output.flush();
+
+		if (stats_on)
+		    reportStats(function.symbol->name(), function.stats);
 	    }
 
-	    functions[function.symbol] = function;
+	    function.release();
+	    functions[function.symbol] = std::move(function);
 	}
 
     } else {
@@ -948,6 +997,182 @@ static void globalDeclaration()
 }
 
 
+/*
+ * Function:	parallel
+ *
+ * Description:	Run the given task for each index less than the given
+ *		count on a pool of worker threads, each of which takes the
+ *		next index until there are none left.
+ */
+
+static void parallel(unsigned count, const function<void(unsigned)> &task)
+{
+    atomic<unsigned> next(0);
+    vector<thread> workers;
+
+
+    for (int i = 0; i < jobs && (unsigned) i < count; i ++)
+	workers.emplace_back([&]() {
+	    for (unsigned j; (j = next ++) < count; )
+		task(j);
+	});
+
+    for (auto &worker : workers)
+	worker.join();
+}
+
+
+/*
+ * Function:	schedule
+ *
+ * Description:	Run the given task for each component of the given call
+ *		graph on a pool of worker threads.  A component is ready
+ *		once the task has finished for every component it calls,
+ *		and each worker takes the next ready component until they
+ *		have all been run.
+ */
+
+static void schedule(const CallGraph &graph,
+	const function<void(unsigned)> &task)
+{
+    mutex lock;
+    condition_variable changed;
+    deque<unsigned> ready;
+    vector<thread> workers;
+    vector<unsigned> waiting(graph.callees);
+    unsigned count = graph.components.size(), finished = 0;
+
+
+    for (unsigned i = 0; i < count; i ++)
+	if (waiting[i] == 0)
+	    ready.push_back(i);
+
+    for (int i = 0; i < jobs && (unsigned) i < count; i ++)
+	workers.emplace_back([&]() {
+	    unique_lock<mutex> guard(lock);
+
+	    while (true) {
+		changed.wait(guard,
+		    [&]() { return !ready.empty() || finished == count; });
+
+		if (ready.empty())
+		    break;
+
+		unsigned next = ready.front();
+		ready.pop_front();
+
+		guard.unlock();
+		task(next);
+		guard.lock();
+
+		finished ++;
+
+		for (auto caller : graph.callers[next])
+		    if (-- waiting[caller] == 0)
+			ready.push_back(caller);
+
+		changed.notify_all();
+	    }
+	});
+
+    for (auto &worker : workers)
+	worker.join();
+}
+
+
+/*
+ * Function:	compileFunctions
+ *
+ * Description:	Compile the pending function definitions concurrently.
+ *		The functions are first translated by the worker threads,
+ *		and then optimized bottom-up over the call graph, so that
+ *		the summaries and saved bodies of the functions each one
+ *		calls are available to it, just as when compiling them in
+ *		order.  Since labels are then numbered in the order they
+ *		happen to be created, they are renumbered in source order,
+ *		so that the output does not depend on the scheduling.  The
+ *		code for each function is then generated into its own
+ *		buffer, and the buffers are written out in source order.
+ *
+ *		The functions are entered in the table beforehand, which
+ *		is not changed while the workers look up their callees.
+ */
+
+static void compileFunctions()
+{
+    Label *label;
+    CallGraph graph;
+    unsigned number = Label::_count;
+    vector<Function *> defined;
+    vector<unsigned> temps(pending.size());
+    vector<ostringstream> buffers(pending.size());
+
+
+    if (pending.empty())
+	return;
+
+    for (auto &function : pending) {
+	Function &entry = functions[function.symbol];
+
+	entry = std::move(function);
+	defined.push_back(&entry);
+    }
+
+    pending.clear();
+
+    parallel(defined.size(), [&](unsigned i) {
+	Timer translation(defined[i]->stats.phases[TRANSLATION]);
+
+	Arena::current(defined[i]->arena);
+	defined[i]->stmts = translate(defined[i]->body);
+	temps[i] = countTemps();
+	Arena::current(nullptr);
+    });
+
+    graph = buildCallGraph(defined);
+
+    schedule(graph, [&](unsigned component) {
+	for (auto i : graph.components[component]) {
+	    Arena::current(defined[i]->arena);
+	    resumeTemps(temps[i]);
+	    optimizeStatements(*defined[i]);
+	    Arena::current(nullptr);
+	}
+    });
+
+    for (auto function : defined)
+	for (auto stmt : function->stmts)
+	    if ((label = stmt->asLabel()) != nullptr)
+		label->_number = number ++;
+
+    Label::_count = number;
+
+    if (output_format == OUTPUT_TAC)
+	for (auto function : defined)
+	    output << function->stmts << '\n' << flush;
+
+    else if (output_format == OUTPUT_ASM) {
+	numberStrings();
+
+	parallel(defined.size(), [&](unsigned i) {
+	    Arena::current(defined[i]->arena);
+	    generateFunction(*defined[i], buffers[i]);
+	    Arena::current(nullptr);
+	});
+
+	for (auto &buffer : buffers)
+	    output << buffer.str() << flush;
+    }
+
+    for (auto function : defined) {
+	if (stats_on)
+	    reportStats(function->symbol->name(), function->stats);
+
+	function->release();
+    }
+}
+
+
 /*
  * Function:	translationUnit
  *
@@ -967,8 +1192,20 @@ static void translationUnit()
     while (word != DONE)
 	globalDeclaration();
 
-    if (output_format == OUTPUT_ASM)
+    compileFunctions();
+
+    if (output_format == OUTPUT_ASM) {
+	Timer generation(phaseTime(GENERATION));
 	generateGlobals(finalizeScope());
+    }
+
+    if (!output.flush()) {
+	perror("write");
+	exit(EXIT_FAILURE);
+    }
+
+    if (stats_on)
+	reportTotals();
 }
 
 
@@ -980,7 +1217,10 @@ static void translationUnit()
 
 static void usage()
 {
-    cerr << "usage: tcc [-A|-S|-T] [file]" << endl;
+    cerr << "usage: tcc [-A|-S|-T] [-m32|-m64] [-j jobs] [-o file] [--dce]";
+    cerr << " [--asimp] [--cfold] [--sccp] [--lvn] [--gvn] [--cprop]";
+    cerr << " [--cse] [--licm] [--ivsr] [--ssa] [--inline] [--tailcall]";
+    cerr << " [--peephole] [--stats] [file]" << endl;
     exit(EXIT_FAILURE);
 }
 
@@ -1007,12 +1247,23 @@ int main(int argc, char *argv[])
 		{"dce", optional_argument, NULL, 'D'},
 		{"cprop", optional_argument, NULL, 'C'},
 		{"lvn", optional_argument, NULL, 'L'},
+		{"gvn", optional_argument, NULL, 'G'},
 		{"asimp", optional_argument, NULL, 'X'},
 		{"cfold", optional_argument, NULL, 'Z'},
+		{"sccp", optional_argument, NULL, 'K'},
+		{"cse", optional_argument, NULL, 'E'},
+		{"licm", optional_argument, NULL, 'H'},
+		{"ivsr", optional_argument, NULL, 'V'},
+		{"ssa", optional_argument, NULL, 'Q'},
+		{"inline", optional_argument, NULL, 'N'},
+		{"tailcall", optional_argument, NULL, 'R'},
+		{"peephole", optional_argument, NULL, 'P'},
+		{"jobs", required_argument, NULL, 'j'},
+		{"output", required_argument, NULL, 'o'},
+		{"stats", optional_argument, NULL, 'I'},
 		{NULL, 0, NULL, 0}
 	};
-	bool opta = false;
-    while ((c = getopt_long(argc, argv, "AOSTDCLXZ", long_opt, NULL)) != -1)
+    while ((c = getopt_long(argc, argv, "AOSTDCLGXZKEHVQNRPIm:j:o:", long_opt, NULL)) != -1)
     //while ((c = getopt(argc, argv, "AOSTDCLXZ")) != -1)
 	switch (c) {
 	    case 'A':
@@ -1033,29 +1284,97 @@ int main(int argc, char *argv[])
 	    case 'O':
 		/* ignored for now */
 		break;
+
+
+	    case 'm':
+		if (string(optarg) == "32")
+		    target64 = 0;
+		else if (string(optarg) == "64")
+		    target64 = 1;
+		else
+		    usage();
+
+		break;
+
+
+	    case 'j':
+		jobs = atoi(optarg);
+
+		if (jobs < 1)
+		    usage();
+
+		break;
+
+
+	    case 'o':
+		if (!emitter.open(optarg)) {
+		    perror(optarg);
+		    exit(errno);
+		}
+
+		break;
+
+		case 'G':
+		gvn_on = 1;
+		break;
 		
 		case 'D':
 		dce_on = 1;
-		opta = 1;
+		break;
 
 		case 'C':
 		cprop_on = 1;
-		opta = 1;
+		break;
 
 		case 'L':
 		lvn_on = 1;
-		opta = 1;
+		break;
 
 		case 'X':
 		asimp_on = 1;
-		opta = 1;
+		break;
 
 		case 'Z':
 		cfold_on = 1;
-		opta = 1;
+		break;
+
+		case 'K':
+		sccp_on = 1;
+		break;
+
+		case 'E':
+		cse_on = 1;
+		break;
+
+		case 'H':
+		licm_on = 1;
+		break;
+
+		case 'V':
+		ivsr_on = 1;
+		break;
+
+		case 'Q':
+		ssa_on = 1;
+		break;
+
+		case 'N':
+		inline_on = 1;
+		break;
+
+		case 'R':
+		tailcall_on = 1;
+		break;
+
+		case 'P':
+		peephole_on = 1;
+		break;
+
+		case 'I':
+		stats_on = 1;
+		break;
 	    
 		default:
-		if(!opta)
 		usage();
 	}
 	/*
@@ -0,0 +1,446 @@
+/*
+ * File:	peephole.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for the peephole optimizer.
+ *
+ *		The optimizer makes passes over the instructions of a
+ *		function, copying each instruction to the output and then
+ *		repeatedly applying the rules to the last few instructions
+ *		of the output until none applies.  Since a rule only looks
+ *		at a window of instructions without any intervening label,
+ *		it never needs to know how control reaches the window.
+ *		Labels that are no longer the target of any jump are
+ *		removed between passes, which can bring more instructions
+ *		together, and so passes are made until nothing changes.
+ */
+
+# include <set>
+# include <unordered_map>
+# include "machine.h"
+# include "peephole.h"
+
+using namespace std;
+
+typedef bool (*Rule)(Instructions &out);
+
+static unordered_map<string, string> inverses = {
+    {"je", "jne"}, {"jne", "je"}, {"jl", "jge"},
+    {"jge", "jl"}, {"jg", "jle"}, {"jle", "jg"},
+};
+
+
+/*
+ * Function:	isLabel (private)
+ *
+ * Description:	Return whether the given instruction is a label.
+ */
+
+static bool isLabel(const Instruction &insn)
+{
+    return !insn.label.empty();
+}
+
+
+/*
+ * Function:	isCode (private)
+ *
+ * Description:	Return whether the given instruction is a real machine
+ *		instruction, rather than a label, directive, or blank line.
+ */
+
+static bool isCode(const Instruction &insn)
+{
+    return !insn.opcode.empty() && insn.opcode[0] != '.';
+}
+
+
+/*
+ * Function:	isJump (private)
+ *
+ * Description:	Return whether the given instruction is an unconditional
+ *		jump.
+ */
+
+static bool isJump(const Instruction &insn)
+{
+    return insn.opcode == "jmp";
+}
+
+
+/*
+ * Function:	isBranch (private)
+ *
+ * Description:	Return whether the given instruction is a conditional
+ *		jump.
+ */
+
+static bool isBranch(const Instruction &insn)
+{
+    return inverses.count(insn.opcode) > 0;
+}
+
+
+/*
+ * Function:	isMove (private)
+ *
+ * Description:	Return whether the given instruction is a simple move.
+ */
+
+static bool isMove(const Instruction &insn)
+{
+    return insn.opcode == "movb" || insn.opcode == "movl" ||
+	insn.opcode == "movq";
+}
+
+
+/*
+ * Function:	isRegister (private)
+ *
+ * Description:	Return whether the given operand is a register.
+ */
+
+static bool isRegister(const string &operand)
+{
+    return !operand.empty() && operand[0] == '%';
+}
+
+
+/*
+ * Function:	isMemory (private)
+ *
+ * Description:	Return whether the given operand is a memory location.
+ */
+
+static bool isMemory(const string &operand)
+{
+    return !operand.empty() && operand[0] != '%' && operand[0] != '$';
+}
+
+
+/*
+ * Function:	selfMove (private)
+ *
+ * Description:	Remove a move of a register to itself.
+ */
+
+static bool selfMove(Instructions &out)
+{
+    const Instruction &last = out.back();
+
+    if (isMove(last) && isRegister(last.operands[0]) &&
+	    last.operands[0] == last.operands[1]) {
+	out.pop_back();
+	return true;
+    }
+
+    return false;
+}
+
+
+/*
+ * Function:	storeLoad (private)
+ *
+ * Description:	Replace a load of a memory location that was just stored
+ *		from a register with a move from that register.  A stored
+ *		character may be reloaded with sign extension.
+ */
+
+static bool storeLoad(Instructions &out)
+{
+    if (out.size() < 2)
+	return false;
+
+    const Instruction &store = out[out.size() - 2];
+    Instruction &load = out.back();
+
+    if (!isMove(store) || !isRegister(store.operands[0]))
+	return false;
+
+    if (!isMemory(store.operands[1]) || load.operands.size() != 2)
+	return false;
+
+    if (load.operands[0] != store.operands[1] || !isRegister(load.operands[1]))
+	return false;
+
+    if (load.opcode == store.opcode ||
+	    (store.opcode == "movb" && load.opcode == "movsbl")) {
+	load.operands[0] = store.operands[0];
+	return true;
+    }
+
+    return false;
+}
+
+
+/*
+ * Function:	deadCode (private)
+ *
+ * Description:	Remove an instruction following an unconditional jump or
+ *		return, since it can only be reached through a label.
+ */
+
+static bool deadCode(Instructions &out)
+{
+    if (out.size() < 2 || !isCode(out.back()))
+	return false;
+
+    const Instruction &prev = out[out.size() - 2];
+
+    if (isJump(prev) || prev.opcode == "ret") {
+	out.pop_back();
+	return true;
+    }
+
+    return false;
+}
+
+
+/*
+ * Function:	jumpToNext (private)
+ *
+ * Description:	Remove a jump, conditional or not, to a label that
+ *		immediately follows it.
+ */
+
+static bool jumpToNext(Instructions &out)
+{
+    unsigned i;
+
+
+    if (!isLabel(out.back()))
+	return false;
+
+    for (i = out.size() - 1; i > 0 && isLabel(out[i - 1]); i --)
+	;
+
+    if (i == 0 || !(isJump(out[i - 1]) || isBranch(out[i - 1])))
+	return false;
+
+    if (out[i - 1].operands[0] != out.back().label)
+	return false;
+
+    out.erase(out.begin() + i - 1);
+    return true;
+}
+
+
+/*
+ * Function:	branchOverJump (private)
+ *
+ * Description:	Replace a conditional jump over an unconditional jump with
+ *		the inverse conditional jump.
+ */
+
+static bool branchOverJump(Instructions &out)
+{
+    if (out.size() < 3 || !isLabel(out.back()))
+	return false;
+
+    Instruction &branch = out[out.size() - 3];
+    const Instruction &jump = out[out.size() - 2];
+
+    if (!isBranch(branch) || !isJump(jump))
+	return false;
+
+    if (branch.operands[0] != out.back().label)
+	return false;
+
+    branch.opcode = inverses.at(branch.opcode);
+    branch.operands[0] = jump.operands[0];
+    out.erase(out.end() - 2);
+    return true;
+}
+
+
+/*
+ * Function:	compareZero (private)
+ *
+ * Description:	Replace a comparison of a register with zero by a test of
+ *		the register against itself, which is shorter.
+ */
+
+static bool compareZero(Instructions &out)
+{
+    Instruction &last = out.back();
+
+    if (last.opcode.compare(0, 3, "cmp") != 0 || last.operands.size() != 2)
+	return false;
+
+    if (last.operands[0] != "$0" || !isRegister(last.operands[1]))
+	return false;
+
+    last.opcode = "test" + last.opcode.substr(3);
+    last.operands[0] = last.operands[1];
+    return true;
+}
+
+
+/*
+ * Function:	repeatedCompare (private)
+ *
+ * Description:	Remove a comparison that repeats the one before a
+ *		conditional jump, since nothing in between changes the
+ *		operands or the flags.
+ */
+
+static bool repeatedCompare(Instructions &out)
+{
+    if (out.size() < 3)
+	return false;
+
+    const Instruction &first = out[out.size() - 3];
+    const Instruction &last = out.back();
+
+    if (first.opcode.compare(0, 3, "cmp") != 0 &&
+	    first.opcode.compare(0, 4, "test") != 0)
+	return false;
+
+    if (!isBranch(out[out.size() - 2]))
+	return false;
+
+    if (last.opcode != first.opcode || last.operands != first.operands)
+	return false;
+
+    out.pop_back();
+    return true;
+}
+
+
+static Rule rules[] = {
+    selfMove, storeLoad, deadCode, jumpToNext, branchOverJump,
+    compareZero, repeatedCompare,
+};
+
+
+/*
+ * Function:	parseInstructions
+ *
+ * Description:	Parse the given assembly text, one instruction per line,
+ *		into a list of instructions.
+ */
+
+Instructions parseInstructions(const string &text)
+{
+    Instructions code;
+    size_t start, end, pos;
+    unsigned depth;
+
+
+    for (start = 0; start < text.size(); start = end + 1) {
+	Instruction insn;
+
+	end = text.find('\n', start);
+
+	if (end == string::npos)
+	    end = text.size();
+
+	string line = text.substr(start, end - start);
+
+	if (!line.empty() && line[0] != '\t' && line.back() == ':')
+	    insn.label = line.substr(0, line.size() - 1);
+
+	else if (!line.empty()) {
+	    pos = line.find('\t', 1);
+	    insn.opcode = line.substr(1, pos - 1);
+
+	    if (pos != string::npos) {
+		string operand;
+
+		depth = 0;
+
+		for (pos ++; pos < line.size(); pos ++)
+		    if (line[pos] == ',' && depth == 0) {
+			insn.operands.push_back(operand);
+			operand.clear();
+
+			if (pos + 1 < line.size() && line[pos + 1] == ' ')
+			    pos ++;
+
+		    } else {
+			if (line[pos] == '(')
+			    depth ++;
+			else if (line[pos] == ')')
+			    depth --;
+
+			operand += line[pos];
+		    }
+
+		insn.operands.push_back(operand);
+	    }
+	}
+
+	code.push_back(insn);
+    }
+
+    return code;
+}
+
+
+/*
+ * Function:	optimizeInstructions
+ *
+ * Description:	Apply the peephole optimizations to the given list of
+ *		instructions until nothing changes.
+ */
+
+void optimizeInstructions(Instructions &code)
+{
+    bool changed;
+    Instructions out;
+    set<string> targets;
+    string prefix = label_prefix;
+
+
+    do {
+	changed = false;
+	targets.clear();
+	out.clear();
+
+	for (auto &insn : code)
+	    if (isJump(insn) || isBranch(insn))
+		targets.insert(insn.operands[0]);
+
+	for (auto &insn : code) {
+	    if (isLabel(insn) && insn.label.compare(0, prefix.size(), prefix) == 0
+		    && targets.count(insn.label) == 0) {
+		changed = true;
+		continue;
+	    }
+
+	    out.push_back(insn);
+
+	    for (unsigned i = 0; !out.empty() && i < sizeof(rules) / sizeof(*rules); )
+		if (rules[i](out)) {
+		    changed = true;
+		    i = 0;
+		} else
+		    i ++;
+	}
+
+	code.swap(out);
+    } while (changed);
+}
+
+
+/*
+ * Function:	operator <<
+ *
+ * Description:	Write an instruction to a stream as a line of assembly,
+ *		without the trailing newline.
+ */
+
+ostream &operator <<(ostream &ostr, const Instruction &insn)
+{
+    if (!insn.label.empty())
+	return ostr << insn.label << ":";
+
+    if (!insn.opcode.empty()) {
+	ostr << "\t" << insn.opcode;
+
+	for (unsigned i = 0; i < insn.operands.size(); i ++)
+	    ostr << (i == 0 ? "\t" : ", ") << insn.operands[i];
+    }
+
+    return ostr;
+}
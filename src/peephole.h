@@ -0,0 +1,33 @@
+/*
+ * File:	peephole.h
+ *
+ * Description:	This file contains the class definition for assembly
+ *		instructions and the public function declarations for the
+ *		peephole optimizer, which works on the instructions
+ *		generated for a single function.
+ *
+ *		An instruction is either a label, an opcode with its
+ *		operands, or a blank line.  Assembler directives are kept
+ *		as instructions whose opcode begins with a period.
+ */
+
+# ifndef PEEPHOLE_H
+# define PEEPHOLE_H
+# include <string>
+# include <vector>
+# include <ostream>
+
+struct Instruction {
+    std::string label;
+    std::string opcode;
+    std::vector<std::string> operands;
+};
+
+typedef std::vector<Instruction> Instructions;
+
+Instructions parseInstructions(const std::string &text);
+void optimizeInstructions(Instructions &code);
+
+std::ostream &operator <<(std::ostream &ostr, const Instruction &insn);
+
+# endif /* PEEPHOLE_H */
@@ -0,0 +1,420 @@
+/*
+ * File:	sccp.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for sparse conditional constant propagation.
+ *
+ *		Each integer local and temporary is given a value in a
+ *		lattice: either a known constant or varying.  The values
+ *		on entry to each block are the meet of the values at the
+ *		end of its predecessors, but only along edges that are
+ *		known to be executable.  An edge out of a block ending in
+ *		a branch becomes executable only if the condition of the
+ *		branch may go that way, so a constant that reaches a
+ *		branch prunes the other arm, and any value assigned only
+ *		in that arm does not spoil the meet.  Blocks are processed
+ *		from a worklist until the values no longer change.
+ *
+ *		A block that is never reached has no values at all, which
+ *		serves as the top of the lattice, and is left alone.  In
+ *		the reached blocks, the operands with constant values are
+ *		replaced with literals, computations with constant results
+ *		become copies, and branches with constant conditions
+ *		become jumps or are removed, so that the blocks that were
+ *		never reached can be swept away by dead code elimination.
+ *
+ *		Since the statements are not in SSA form, the values are
+ *		kept per block rather than per variable.  Only the
+ *		constants are recorded, and a variable that is absent is
+ *		varying.
+ */
+
+# include <deque>
+# include <climits>
+# include <unordered_map>
+# include <unordered_set>
+# include "flowgraph.h"
+# include "literal.h"
+# include "sccp.h"
+
+using namespace std;
+
+typedef unordered_map<Symbol *, int> Constants;
+
+
+/*
+ * Function:	isTracked (private)
+ *
+ * Description:	Return whether the value of the given symbol is tracked.
+ *		Globals may be changed by any call, and characters are
+ *		truncated when assigned, so only integer locals and
+ *		temporaries are tracked.
+ */
+
+static bool isTracked(Symbol *sym)
+{
+    if (sym == nullptr || (sym->kind() != LOCAL && sym->kind() != TEMP))
+	return false;
+
+    return sym->type().isScalar() && sym->type().specifier() == INT;
+}
+
+
+/*
+ * Function:	valueOf (private)
+ *
+ * Description:	Set the value of the given symbol if it is a constant in
+ *		the given set, and return whether it is.
+ */
+
+static bool valueOf(Symbol *sym, const Constants &values, int &value)
+{
+    if (isNumber(sym)) {
+	value = valueOf(sym);
+	return true;
+    }
+
+    auto it = values.find(sym);
+
+    if (it == values.end())
+	return false;
+
+    value = it->second;
+    return true;
+}
+
+
+/*
+ * Function:	evaluate (private)
+ *
+ * Description:	Compute the result of applying the given operator to the
+ *		given operands, and return whether it could be computed.
+ *		Arithmetic wraps around as it does on the machine, and
+ *		divisions that would trap are not computed.
+ */
+
+static bool evaluate(int token, int left, int right, int &result)
+{
+    unsigned a = left, b = right;
+
+
+    switch (token) {
+    case '+': result = a + b; return true;
+    case '-': result = a - b; return true;
+    case '*': result = a * b; return true;
+    case '<': result = left < right; return true;
+    case '>': result = left > right; return true;
+    case LEQ: result = left <= right; return true;
+    case GEQ: result = left >= right; return true;
+    case EQL: result = left == right; return true;
+    case NEQ: result = left != right; return true;
+    case NEGATE: result = -a; return true;
+    case INT: result = (char) left; return true;
+    }
+
+    if (right == 0 || (left == INT_MIN && right == -1))
+	return false;
+
+    if (token == '/')
+	result = left / right;
+    else if (token == '%')
+	result = left % right;
+    else
+	return false;
+
+    return true;
+}
+
+
+/*
+ * Function:	fold (private)
+ *
+ * Description:	Compute the value that the given statement assigns to its
+ *		result, using the given constants, and return whether it
+ *		is a constant.  The value of a branch is its condition.
+ */
+
+static bool fold(Statement *stmt, const Constants &values, int &value)
+{
+    int left, right;
+    Copy *copy;
+    Unary *unary;
+    Binary *binary;
+    Branch *branch;
+
+
+    if ((copy = dynamic_cast<Copy *>(stmt)) != nullptr)
+	return valueOf(copy->_expr, values, value);
+
+    if ((unary = dynamic_cast<Unary *>(stmt)) != nullptr)
+	return valueOf(unary->_expr, values, left) &&
+	    evaluate(unary->_token, left, 0, value);
+
+    if ((binary = dynamic_cast<Binary *>(stmt)) != nullptr)
+	return valueOf(binary->_left, values, left) &&
+	    valueOf(binary->_right, values, right) &&
+	    evaluate(binary->_token, left, right, value);
+
+    if ((branch = dynamic_cast<Branch *>(stmt)) != nullptr)
+	return valueOf(branch->_left, values, left) &&
+	    valueOf(branch->_right, values, right) &&
+	    evaluate(branch->_token, left, right, value);
+
+    return false;
+}
+
+
+/*
+ * Function:	transfer (private)
+ *
+ * Description:	Update the given constants to reflect the execution of
+ *		the given statement.
+ */
+
+static void transfer(Statement *stmt, Constants &values)
+{
+    int value;
+    Symbol *result;
+
+
+    result = stmt->result();
+
+    if (!isTracked(result))
+	return;
+
+    if (fold(stmt, values, value))
+	values[result] = value;
+    else
+	values.erase(result);
+}
+
+
+/*
+ * Function:	meet (private)
+ *
+ * Description:	Meet the given constants into the constants on entry to a
+ *		block, keeping only those that agree, and return whether
+ *		the constants on entry changed.
+ */
+
+static bool meet(Constants &entry, const Constants &values)
+{
+    bool changed = false;
+
+
+    for (auto it = entry.begin(); it != entry.end(); ) {
+	auto other = values.find(it->first);
+
+	if (other == values.end() || other->second != it->second) {
+	    it = entry.erase(it);
+	    changed = true;
+	} else
+	    it ++;
+    }
+
+    return changed;
+}
+
+
+/*
+ * Function:	successors (private)
+ *
+ * Description:	Return the successors of the given block that may be
+ *		reached given the constants at its end.  If the block ends
+ *		with a branch whose condition is a constant, only one of
+ *		its successors may be reached.
+ */
+
+static Blocks successors(Block *block, const Constants &values)
+{
+    int taken;
+    Branch *branch;
+
+
+    if (block->begin() == block->end())
+	return block->successors();
+
+    branch = dynamic_cast<Branch *>(*prev(block->end()));
+
+    if (branch == nullptr || !fold(branch, values, taken))
+	return block->successors();
+
+    if (taken)
+	return Blocks(1, branch->_target->_block);
+
+    return Blocks(1, block->next());
+}
+
+
+/*
+ * Function:	analyze (private)
+ *
+ * Description:	Compute the constants on entry to each reachable block.
+ *		A block that is not in the result is never reached.
+ */
+
+static unordered_map<Block *, Constants> analyze(Function &function)
+{
+    Constants values;
+    deque<Block *> worklist;
+    unordered_set<Block *> queued;
+    unordered_map<Block *, Constants> entries;
+
+
+    entries[function.entry] = Constants();
+    worklist.push_back(function.entry);
+    queued.insert(function.entry);
+
+    while (!worklist.empty()) {
+	Block *block = worklist.front();
+	worklist.pop_front();
+	queued.erase(block);
+
+	values = entries[block];
+
+	for (auto stmt : *block)
+	    transfer(stmt, values);
+
+	for (auto succ : successors(block, values)) {
+	    auto it = entries.find(succ);
+	    bool changed = false;
+
+	    if (it == entries.end()) {
+		entries[succ] = values;
+		changed = true;
+	    } else
+		changed = meet(it->second, values);
+
+	    if (changed && queued.insert(succ).second)
+		worklist.push_back(succ);
+	}
+    }
+
+    return entries;
+}
+
+
+/*
+ * Function:	replace (private)
+ *
+ * Description:	Replace the given operand with a literal if it has a
+ *		constant value, and return whether it was replaced.
+ */
+
+static bool replace(Symbol *&sym, const Constants &values)
+{
+    auto it = values.find(sym);
+
+
+    if (it == values.end())
+	return false;
+
+    sym = makeLiteral(it->second);
+    return true;
+}
+
+
+/*
+ * Function:	substitute (private)
+ *
+ * Description:	Replace the operands of the given statement that have
+ *		constant values with literals, and return whether any were
+ *		replaced.  Array indices are left alone, since the code
+ *		generator expects them in registers.
+ */
+
+static bool substitute(Statement *stmt, const Constants &values)
+{
+    bool changed = false;
+    Call *call;
+    Copy *copy;
+    Binary *binary;
+    Branch *branch;
+    Return *ret;
+    Update *update;
+
+
+    if ((binary = dynamic_cast<Binary *>(stmt)) != nullptr) {
+	changed = replace(binary->_left, values);
+	changed = replace(binary->_right, values) || changed;
+
+    } else if ((branch = dynamic_cast<Branch *>(stmt)) != nullptr) {
+	changed = replace(branch->_left, values);
+	changed = replace(branch->_right, values) || changed;
+
+    } else if ((copy = dynamic_cast<Copy *>(stmt)) != nullptr)
+	changed = replace(copy->_expr, values);
+
+    else if ((ret = dynamic_cast<Return *>(stmt)) != nullptr)
+	changed = ret->_expr != nullptr && replace(ret->_expr, values);
+
+    else if ((update = dynamic_cast<Update *>(stmt)) != nullptr)
+	changed = replace(update->_expr, values);
+
+    else if ((call = dynamic_cast<Call *>(stmt)) != nullptr)
+	for (auto &arg : call->_arguments)
+	    changed = replace(arg, values) || changed;
+
+    return changed;
+}
+
+
+/*
+ * Function:	propagateConstants
+ *
+ * Description:	Propagate constants through the function, fold the
+ *		statements and branches whose values are then known, and
+ *		return whether anything was changed.
+ */
+
+bool propagateConstants(Function &function)
+{
+    int value;
+    bool changed;
+    Statement *stmt;
+    Constants values;
+    unordered_map<Block *, Constants> entries;
+
+
+    changed = false;
+    entries = analyze(function);
+
+    for (auto block : getBlocks(function)) {
+	if (entries.count(block) == 0)
+	    continue;
+
+	values = entries[block];
+	auto it = block->begin();
+
+	while (it != block->end()) {
+	    stmt = *it;
+
+	    if (dynamic_cast<Branch *>(stmt) && fold(stmt, values, value)) {
+		if (value)
+		    it = replaceStatement(function, block, it,
+			new Jump(stmt->target()));
+		else
+		    it = eraseStatement(function, block, it);
+
+		changed = true;
+		continue;
+	    }
+
+	    if (isTracked(stmt->result()))
+		if (!dynamic_cast<Copy *>(stmt) && fold(stmt, values, value)) {
+		    it = replaceStatement(function, block, it,
+			new Copy(stmt->result(), makeLiteral(value)));
+		    stmt = *it;
+		    changed = true;
+		}
+
+	    if (substitute(stmt, values))
+		changed = true;
+
+	    transfer(stmt, values);
+	    it ++;
+	}
+    }
+
+    return changed;
+}
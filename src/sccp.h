@@ -0,0 +1,14 @@
+/*
+ * File:	sccp.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		sparse conditional constant propagation.
+ */
+
+# ifndef SCCP_H
+# define SCCP_H
+# include "Function.h"
+
+bool propagateConstants(Function &function);
+
+# endif /* SCCP_H */
@@ -0,0 +1,120 @@
+/*
+ * File:	solver.h
+ *
+ * Description:	This file contains a generic worklist solver for bit-vector
+ *		dataflow problems over the control-flow graph.  A problem
+ *		is described by its direction, its meet operator, and the
+ *		transfer function of each block.
+ *
+ *		For a forward problem, the input of a block is the meet of
+ *		the outputs of its predecessors, and the input of the entry
+ *		block is the boundary value.  For a backward problem, the
+ *		input of a block is the meet of the outputs of its
+ *		successors, and the input of the exit block is the boundary
+ *		value.  The input of each block is stored through the given
+ *		accessor, since that is what the optimizations consult.
+ *
+ *		Blocks are visited in reverse postorder for forward
+ *		problems and in postorder for backward problems, and a
+ *		block is only revisited when the output of one of its
+ *		neighbors actually changes.
+ */
+
+# ifndef SOLVER_H
+# define SOLVER_H
+# include <vector>
+# include <algorithm>
+# include <unordered_map>
+# include "flowgraph.h"
+# include "BitVector.h"
+
+enum Direction { FORWARD, BACKWARD };
+
+
+/* The meet operator for "any path" problems */
+
+struct Union {
+    BitVector top(unsigned size) const { return BitVector(size); }
+    void operator()(BitVector &s1, const BitVector &s2) const { s1 |= s2; }
+};
+
+
+/* The meet operator for "all paths" problems */
+
+struct Intersection {
+    BitVector top(unsigned size) const { return BitVector(size, true); }
+    void operator()(BitVector &s1, const BitVector &s2) const { s1 &= s2; }
+};
+
+
+/*
+ * Function:	solve
+ *
+ * Description:	Solve the given dataflow problem over sets drawn from a
+ *		universe of the given size, and return the number of block
+ *		visits required to reach the fixed point.  The transfer
+ *		function is called as transfer(block, input, output).
+ */
+
+template<class Meet, class Transfer, class Input>
+unsigned solve(Function &function, Direction direction, unsigned size,
+	const BitVector &boundary, Meet meet, Transfer transfer, Input input)
+{
+    Blocks order;
+    Block *boundary_block;
+    unsigned visits;
+    BitVector in, out;
+    std::unordered_map<Block *, unsigned> position;
+
+
+    order = reversePostorder(function);
+
+    if (direction == BACKWARD)
+	std::reverse(order.begin(), order.end());
+
+    for (unsigned i = 0; i < order.size(); i ++)
+	position[order[i]] = i;
+
+    boundary_block = (direction == FORWARD ? function.entry : function.exit);
+
+    std::vector<BitVector> output(order.size(), meet.top(size));
+    BitVector pending(order.size(), true);
+    visits = 0;
+
+    while (!pending.empty())
+	for (unsigned i = pending.first(); i < order.size(); i = pending.next(i)) {
+	    Block *block = order[i];
+	    const Blocks &sources = (direction == FORWARD ?
+		block->predecessors() : block->successors());
+	    const Blocks &sinks = (direction == FORWARD ?
+		block->successors() : block->predecessors());
+
+	    pending.reset(i);
+	    visits ++;
+
+	    if (block == boundary_block)
+		in = boundary;
+	    else {
+		in = meet.top(size);
+
+		for (auto source : sources)
+		    meet(in, output[position[source]]);
+	    }
+
+	    input(block) = in;
+	    out = in;
+	    transfer(block, in, out);
+
+	    if (out != output[i]) {
+		output[i] = out;
+
+		for (auto sink : sinks)
+		    pending.set(position[sink]);
+	    }
+	}
+
+    function.stats.visits += visits;
+    return visits;
+}
+
+# endif /* SOLVER_H */
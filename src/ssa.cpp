@@ -0,0 +1,500 @@
+/*
+ * File:	ssa.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for converting a function into and out of
+ *		static single assignment (SSA) form.
+ *
+ *		On the way in, a phi statement is placed at the start of
+ *		each block in the iterated dominance frontier of the
+ *		assignments to a variable, but only where the variable is
+ *		live, and every assignment is then given a new version of
+ *		its variable by walking the dominator tree.  A phi
+ *		statement has one operand for each predecessor of its
+ *		block, keyed by the predecessor itself, so that the passes
+ *		that remove edges, or even whole blocks, leave them
+ *		meaningful.  Only scalar locals and temporaries are
+ *		renamed, since arrays are updated in place and globals
+ *		may be assigned by any call.  The version of a variable on
+ *		entry to the function is the variable itself, so that
+ *		parameters are still found in their usual places.
+ *
+ *		On the way out, each phi statement becomes a set of copies
+ *		at the end of its predecessors.  The copies along an edge
+ *		happen in parallel, so they are ordered to avoid
+ *		overwriting a variable that is still to be read, with a
+ *		temporary breaking any cycle.  An edge leaving a block
+ *		with a branch is first split by a new block, so that the
+ *		copies are only made along that edge.
+ *
+ *		While in SSA form, a copy can be propagated to every use
+ *		of its result without any data-flow analysis, which we do
+ *		with the help of the def-use index.
+ */
+
+# include <cassert>
+# include <algorithm>
+# include <unordered_map>
+# include <unordered_set>
+# include "flowgraph.h"
+# include "optimizer.h"
+# include "defuse.h"
+# include "ssa.h"
+
+using namespace std;
+
+typedef unordered_map<Symbol *, Symbols> Stacks;
+typedef vector<pair<Symbol *, Symbol *>> Copies;
+
+
+/*
+ * Function:	isRenamed (private)
+ *
+ * Description:	Return whether the given symbol is renamed in SSA form.
+ */
+
+static bool isRenamed(Symbol *sym)
+{
+    if (sym == nullptr || (sym->kind() != LOCAL && sym->kind() != TEMP))
+	return false;
+
+    return sym->type().isScalar();
+}
+
+
+/*
+ * Function:	current (private)
+ *
+ * Description:	Return the current version of the given symbol.
+ */
+
+static Symbol *current(Symbol *sym, const Stacks &stacks)
+{
+    auto it = stacks.find(sym);
+
+
+    if (it == stacks.end() || it->second.empty())
+	return sym;
+
+    return it->second.back();
+}
+
+
+/*
+ * Function:	insertPhis (private)
+ *
+ * Description:	Insert a phi statement for each renamed variable at the
+ *		start of each block in the iterated dominance frontier of
+ *		the blocks that assign it, if the variable is live there,
+ *		and record the variable of each phi statement.  The
+ *		dominators, frontiers, and liveness must be up to date.
+ */
+
+static void insertPhis(Function &function, const Symbols &variables,
+	unordered_map<Symbol *, Blocks> &defsites,
+	unordered_map<Phi *, Symbol *> &phis)
+{
+    Phi *phi;
+    Blocks worklist;
+    unordered_set<Block *> placed, assigned;
+
+
+    for (auto var : variables) {
+	worklist = defsites[var];
+	assigned = unordered_set<Block *>(worklist.begin(), worklist.end());
+	placed.clear();
+
+	while (!worklist.empty()) {
+	    Block *block = worklist.back();
+	    worklist.pop_back();
+
+	    for (auto join : block->frontier()) {
+		if (join == function.exit || !placed.insert(join).second)
+		    continue;
+
+		if (!isLiveIn(join, var))
+		    continue;
+
+		phi = new Phi(var, join->predecessors());
+		insertStatement(function, join, join->begin(), phi);
+		phis[phi] = var;
+
+		if (assigned.insert(join).second)
+		    worklist.push_back(join);
+	    }
+	}
+    }
+}
+
+
+/*
+ * Function:	rename (private)
+ *
+ * Description:	Give each assignment in the given block and the blocks it
+ *		dominates a new version of its variable, and replace each
+ *		use with the version that reaches it, including the phi
+ *		operands in the successors of each block.
+ */
+
+static void rename(Block *block, Stacks &stacks,
+	unordered_map<Symbol *, unsigned> &counts,
+	unordered_map<Phi *, Symbol *> &phis)
+{
+    Phi *phi;
+    Symbol *var, *version;
+    Symbols pushed;
+
+
+    for (auto stmt : *block) {
+	if (dynamic_cast<Phi *>(stmt) == nullptr)
+	    for (unsigned i = 0; i < stmt->uses(); i ++)
+		stmt->use(i) = current(stmt->use(i), stacks);
+
+	var = stmt->result();
+
+	if (var == nullptr || stacks.count(var) == 0)
+	    continue;
+
+	string name = var->name() + "." + to_string(++ counts[var]);
+
+	version = new (*Arena::current())
+	    Symbol(name, var->type(), var->kind());
+	stmt->result(version);
+	stacks[var].push_back(version);
+	pushed.push_back(var);
+    }
+
+    for (auto succ : block->successors())
+	for (auto stmt : *succ) {
+	    if ((phi = dynamic_cast<Phi *>(stmt)) == nullptr)
+		break;
+
+	    for (unsigned i = 0; i < phi->_predecessors.size(); i ++)
+		if (phi->_predecessors[i] == block)
+		    phi->_operands[i] = current(phis[phi], stacks);
+	}
+
+    for (auto child : block->dominated())
+	rename(child, stacks, counts, phis);
+
+    for (auto var : pushed)
+	stacks[var].pop_back();
+}
+
+
+/*
+ * Function:	buildSSA
+ *
+ * Description:	Convert the function into pruned SSA form and return
+ *		whether any variable was renamed.
+ */
+
+bool buildSSA(Function &function)
+{
+    Symbol *result;
+    Symbols variables;
+    Stacks stacks;
+    unordered_map<Symbol *, unsigned> counts;
+    unordered_map<Symbol *, Blocks> defsites;
+    unordered_map<Phi *, Symbol *> phis;
+
+
+    computeDominators(function);
+    computeFrontiers(function);
+    doLVA(function);
+
+    assert(function.entry->predecessors().empty());
+
+    for (auto block : getBlocks(function)) {
+	if (block != function.entry && block->idom() == nullptr)
+	    continue;
+
+	for (auto stmt : *block) {
+	    result = stmt->result();
+
+	    if (!isRenamed(result))
+		continue;
+
+	    if (counts[result] ++ == 0)
+		variables.push_back(result);
+
+	    Blocks &sites = defsites[result];
+
+	    if (sites.empty() || sites.back() != block)
+		sites.push_back(block);
+	}
+    }
+
+    insertPhis(function, variables, defsites, phis);
+
+
+    /*
+     * A variable assigned once and never merged is already in SSA form,
+     * unless it is also live on entry, in which case its assignment does
+     * not dominate all of its uses.
+     */
+
+    for (auto &phi : phis)
+	counts[phi.second] ++;
+
+    for (auto var : variables)
+	if (counts[var] > 1 || isLiveIn(function.entry, var))
+	    stacks[var] = Symbols();
+
+    if (stacks.empty())
+	return false;
+
+    counts.clear();
+    rename(function.entry, stacks, counts, phis);
+    return true;
+}
+
+
+/*
+ * Function:	sequentialize (private)
+ *
+ * Description:	Return statements performing the given parallel copies one
+ *		at a time.  A copy is made only once its result is no
+ *		longer needed by any other copy.  If every remaining
+ *		result is still needed, then they form cycles, and one is
+ *		broken by saving a result in a temporary first.
+ */
+
+static Statements sequentialize(Copies copies)
+{
+    Statements stmts;
+    Symbol *result, *temp;
+    unsigned i, j;
+
+
+    while (!copies.empty()) {
+	for (i = 0; i < copies.size(); i ++) {
+	    for (j = 0; j < copies.size(); j ++)
+		if (copies[j].second == copies[i].first)
+		    break;
+
+	    if (j == copies.size())
+		break;
+	}
+
+	if (i < copies.size()) {
+	    stmts.push_back(new Copy(copies[i].first, copies[i].second));
+	    copies.erase(copies.begin() + i);
+	    continue;
+	}
+
+	result = copies.front().first;
+	temp = new (*Arena::current())
+	    Symbol(result->name() + "'", result->type(), TEMP);
+	stmts.push_back(new Copy(temp, result));
+
+	for (auto &copy : copies)
+	    if (copy.second == result)
+		copy.second = temp;
+    }
+
+    return stmts;
+}
+
+
+/*
+ * Function:	splitEdge (private)
+ *
+ * Description:	Place the given statements along the edge from the given
+ *		branch to the given successor.
+ *		If the successor is reached by falling through, the
+ *		statements are placed in a new block between the two.
+ *		Otherwise, they are placed in a new block at the end of
+ *		the function that jumps to the successor, and the branch
+ *		is redirected to it.
+ */
+
+static void splitEdge(Function &function, Branch *branch, Block *succ,
+	Statements &stmts, bool taken)
+{
+    Label *label, *target;
+    Statements::iterator pos;
+
+
+    label = new Label();
+    target = (*succ->first())->asLabel();
+
+    if (taken) {
+	pos = prev(function.stmts.end());
+
+	if ((*prev(pos))->fallsThru())
+	    function.stmts.insert(pos, new Jump((*pos)->asLabel()));
+
+	branch->target(label);
+	stmts.push_back(new Jump(target));
+    } else
+	pos = succ->first();
+
+    function.stmts.insert(pos, label);
+
+    while (!stmts.empty()) {
+	Statement *stmt = stmts.front();
+	stmts.erase(stmts.begin());
+	function.stmts.insert(pos, stmt);
+    }
+}
+
+
+/*
+ * Function:	destroySSA
+ *
+ * Description:	Replace the phi statements in the function with copies
+ *		and return whether there were any.  The flowgraph is
+ *		rebuilt afterwards, since new blocks may be created.
+ */
+
+bool destroySSA(Function &function)
+{
+    Phi *phi;
+    Branch *branch;
+    Statements stmts;
+    vector<Phi *> phis;
+    Statements::iterator pos;
+    bool changed;
+
+
+    changed = false;
+
+    for (auto block : getBlocks(function)) {
+	phis.clear();
+
+	for (auto stmt : *block) {
+	    if ((phi = dynamic_cast<Phi *>(stmt)) == nullptr)
+		break;
+
+	    phis.push_back(phi);
+	}
+
+	if (phis.empty())
+	    continue;
+
+	Blocks preds;
+
+	for (auto pred : block->predecessors())
+	    if (find(preds.begin(), preds.end(), pred) == preds.end())
+		preds.push_back(pred);
+
+	for (auto pred : preds) {
+	    Copies copies;
+
+	    for (auto phi : phis)
+		for (unsigned i = 0; i < phi->_predecessors.size(); i ++)
+		    if (phi->_predecessors[i] == pred) {
+			if (phi->_operands[i] != phi->_result)
+			    copies.push_back(make_pair(phi->_result,
+				phi->_operands[i]));
+			break;
+		    }
+
+	    if (copies.empty())
+		continue;
+
+	    branch = nullptr;
+
+	    if (pred->begin() != pred->end())
+		branch = dynamic_cast<Branch *>(*prev(pred->end()));
+
+	    if (branch != nullptr) {
+		if (branch->_target->_block == block) {
+		    stmts = sequentialize(copies);
+		    splitEdge(function, branch, block, stmts, true);
+		}
+
+		if (pred->next() == block) {
+		    stmts = sequentialize(copies);
+		    splitEdge(function, branch, block, stmts, false);
+		}
+
+		continue;
+	    }
+
+	    pos = pred->end();
+
+	    if (pos != pred->begin() && (*prev(pos))->target() != nullptr)
+		pos --;
+
+	    stmts = sequentialize(copies);
+
+	    while (!stmts.empty()) {
+		Statement *stmt = stmts.front();
+		stmts.erase(stmts.begin());
+		function.stmts.insert(pos, stmt);
+	    }
+	}
+
+	for (auto phi : phis) {
+	    function.stmts.erase(block->begin());
+	    delete phi;
+	}
+
+	changed = true;
+    }
+
+    if (changed)
+	rebuildFlowgraph(function);
+
+    return changed;
+}
+
+
+/*
+ * Function:	propagateCopies
+ *
+ * Description:	Replace every use of the result of a copy with the symbol
+ *		copied, and remove the copy, returning whether any copy
+ *		was removed.  The function must be in SSA form, and so
+ *		each use of the result is dominated by the copy.  If the
+ *		symbol copied is assigned at most once, then that
+ *		assignment dominates the copy and the symbol still holds
+ *		the same value at every use.  The def-use index takes us
+ *		straight to the uses, and keeps track of the uses of the
+ *		symbol copied as they grow, so chains of copies collapse
+ *		in a single pass.
+ */
+
+bool propagateCopies(Function &function)
+{
+    Copy *copy;
+    bool changed;
+    vector<Copy *> copies;
+
+
+    DefUse index(function);
+    changed = false;
+
+    for (auto block : getBlocks(function))
+	for (auto stmt : *block)
+	    if ((copy = dynamic_cast<Copy *>(stmt)) != nullptr)
+		copies.push_back(copy);
+
+    for (auto copy : copies) {
+	Symbol *result = copy->_result, *expr = copy->_expr;
+
+	if (!isRenamed(result) || !isRenamed(expr) || result == expr)
+	    continue;
+
+	if (result->type().specifier() != expr->type().specifier())
+	    continue;
+
+	if (index.defs(result).size() != 1 || index.defs(expr).size() > 1)
+	    continue;
+
+	while (!index.uses(result).empty()) {
+	    Statement *stmt = index.uses(result).back();
+
+	    for (unsigned i = 0; i < stmt->uses(); i ++)
+		if (stmt->use(i) == result)
+		    index.replace(stmt, i, expr);
+	}
+
+	index.erase(copy);
+	changed = true;
+    }
+
+    return changed;
+}
@@ -0,0 +1,18 @@
+/*
+ * File:	ssa.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		converting a function into and out of static single
+ *		assignment (SSA) form.
+ */
+
+# ifndef SSA_H
+# define SSA_H
+# include "Function.h"
+
+bool buildSSA(Function &function);
+bool destroySSA(Function &function);
+
+bool propagateCopies(Function &function);
+
+# endif /* SSA_H */
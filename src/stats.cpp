@@ -0,0 +1,329 @@
+/*
+ * File:	stats.cpp
+ *
+ * Description:	This file contains the member and public function
+ *		definitions for the statistics gathered about optimizing
+ *		each function.
+ *
+ *		A statement is counted as rewritten if it was created by
+ *		the pass or if its printed form was changed by the pass.
+ *		Finding this out requires printing the function before and
+ *		after the pass, so it is only done when statistics were
+ *		asked for, and is not included in the time of the pass.
+ */
+
+# include <chrono>
+# include <iomanip>
+# include <sstream>
+# include <iostream>
+# include <unordered_map>
+# include <sys/resource.h>
+# include "Function.h"
+# include "opflgs.h"
+# include "stats.h"
+
+using namespace std;
+using namespace std::chrono;
+
+static Stats totals;
+static unsigned reported;
+
+static const char *phases[NUM_PHASES] = {
+    "lexing", "parsing", "translation", "optimization", "generation",
+};
+
+
+/*
+ * Function:	PassStats::PassStats (constructor)
+ *
+ * Description:	Initialize the statistics for the given pass.
+ */
+
+PassStats::PassStats(const string &name)
+    : name(name), runs(0), changes(0), visits(0), rebuilds(0), removed(0),
+      rewritten(0), seconds(0)
+{
+}
+
+
+/*
+ * Function:	Stats::Stats (constructor)
+ *
+ * Description:	Initialize the statistics for a function.
+ */
+
+Stats::Stats()
+    : rounds(0), visits(0), rebuilds(0), before(0), after(0), overhead(0)
+{
+    for (unsigned i = 0; i < NUM_PHASES; i ++)
+	phases[i] = 0;
+}
+
+
+/*
+ * Function:	Stats::pass
+ *
+ * Description:	Return the statistics for the pass with the given name,
+ *		adding them if the pass has not yet been run.
+ */
+
+PassStats &Stats::pass(const string &name)
+{
+    for (auto &pass : passes)
+	if (pass.name == name)
+	    return pass;
+
+    passes.push_back(PassStats(name));
+    return passes.back();
+}
+
+
+/*
+ * Function:	Stats::add
+ *
+ * Description:	Add the given statistics to these statistics.
+ */
+
+void Stats::add(const Stats &stats)
+{
+    rounds += stats.rounds;
+    visits += stats.visits;
+    rebuilds += stats.rebuilds;
+    before += stats.before;
+    after += stats.after;
+    overhead += stats.overhead;
+
+    for (unsigned i = 0; i < NUM_PHASES; i ++)
+	phases[i] += stats.phases[i];
+
+    for (auto &other : stats.passes) {
+	PassStats &ours = pass(other.name);
+
+	ours.runs += other.runs;
+	ours.changes += other.changes;
+	ours.visits += other.visits;
+	ours.rebuilds += other.rebuilds;
+	ours.removed += other.removed;
+	ours.rewritten += other.rewritten;
+	ours.seconds += other.seconds;
+    }
+}
+
+
+/*
+ * Function:	Timer::Timer (constructor)
+ *
+ * Description:	Start timing if statistics were asked for.  The elapsed
+ *		time will be added to the given total.
+ */
+
+Timer::Timer(double &seconds)
+    : _seconds(stats_on ? &seconds : nullptr)
+{
+    if (_seconds != nullptr)
+	_start = steady_clock::now();
+}
+
+
+/*
+ * Function:	Timer::~Timer (destructor)
+ *
+ * Description:	Stop timing, if not already stopped.
+ */
+
+Timer::~Timer()
+{
+    stop();
+}
+
+
+/*
+ * Function:	Timer::stop
+ *
+ * Description:	Stop timing and add the elapsed time to the total.
+ */
+
+void Timer::stop()
+{
+    if (_seconds != nullptr) {
+	*_seconds += duration<double>(steady_clock::now() - _start).count();
+	_seconds = nullptr;
+    }
+}
+
+
+/*
+ * Function:	phaseTime
+ *
+ * Description:	Return the total time spent in the given phase for the
+ *		whole unit.  Only the main thread may use the total.
+ */
+
+double &phaseTime(Phase phase)
+{
+    return totals.phases[phase];
+}
+
+
+/*
+ * Function:	text (private)
+ *
+ * Description:	Return the printed form of the given statement.
+ */
+
+static string text(Statement *stmt)
+{
+    ostringstream ostr;
+
+    ostr << stmt;
+    return ostr.str();
+}
+
+
+/*
+ * Function:	runPass
+ *
+ * Description:	Run the given pass over the given function, recording
+ *		statistics about it if they were asked for, and return
+ *		whether the pass changed the function.
+ */
+
+bool runPass(Function &function, const string &name,
+	bool (*pass)(Function &))
+{
+    bool changed;
+    unsigned visits, rebuilds;
+    int size;
+    unordered_map<Statement *, string> before;
+
+
+    if (!stats_on)
+	return pass(function);
+
+    auto begin = steady_clock::now();
+
+    for (auto stmt : function.stmts)
+	before[stmt] = text(stmt);
+
+    size = function.stmts.size();
+    visits = function.stats.visits;
+    rebuilds = function.stats.rebuilds;
+
+    auto start = steady_clock::now();
+    changed = pass(function);
+    auto stop = steady_clock::now();
+
+    PassStats &stats = function.stats.pass(name);
+
+    stats.runs ++;
+    stats.changes += changed;
+    stats.seconds += duration<double>(stop - start).count();
+    stats.visits += function.stats.visits - visits;
+    stats.rebuilds += function.stats.rebuilds - rebuilds;
+    stats.removed += size - (int) function.stmts.size();
+
+    for (auto stmt : function.stmts) {
+	auto it = before.find(stmt);
+
+	if (it == before.end() || it->second != text(stmt))
+	    stats.rewritten ++;
+    }
+
+    auto end = steady_clock::now();
+    function.stats.overhead += duration<double>(end - begin).count();
+    function.stats.overhead -= duration<double>(stop - start).count();
+
+    return changed;
+}
+
+
+/*
+ * Function:	write (private)
+ *
+ * Description:	Write the given statistics to the standard error as a
+ *		table.
+ */
+
+static void write(const string &name, const Stats &stats)
+{
+    double seconds = 0;
+
+
+    for (auto &pass : stats.passes)
+	seconds += pass.seconds;
+
+    cerr << name << ": " << stats.rounds << " rounds, ";
+    cerr << stats.before << " -> " << stats.after << " statements, ";
+    cerr << stats.rebuilds << " rebuilds, " << stats.visits << " visits, ";
+    cerr << fixed << setprecision(3) << seconds * 1000 << " ms" << endl;
+
+    cerr << "  " << left << setw(8) << "pass" << right;
+    cerr << setw(8) << "runs" << setw(8) << "changed";
+    cerr << setw(8) << "removed" << setw(10) << "rewritten";
+    cerr << setw(8) << "visits" << setw(9) << "rebuilds";
+    cerr << setw(10) << "ms" << endl;
+
+    for (auto &pass : stats.passes) {
+	cerr << "  " << left << setw(8) << pass.name << right;
+	cerr << setw(8) << pass.runs << setw(8) << pass.changes;
+	cerr << setw(8) << pass.removed << setw(10) << pass.rewritten;
+	cerr << setw(8) << pass.visits << setw(9) << pass.rebuilds;
+	cerr << setw(10) << pass.seconds * 1000 << endl;
+    }
+}
+
+
+/*
+ * Function:	reportStats
+ *
+ * Description:	Write the statistics for the given function to the
+ *		standard error, and add them to the totals.
+ */
+
+void reportStats(const string &name, const Stats &stats)
+{
+    write(name, stats);
+    totals.add(stats);
+    reported ++;
+}
+
+
+/*
+ * Function:	reportTotals
+ *
+ * Description:	Write the statistics for all functions reported so far to
+ *		the standard error, if there was more than one, followed by
+ *		the time spent in each phase and the peak memory use.
+ *		Since lexing happens on demand during parsing, its time is
+ *		taken out of the time for parsing.  The overhead of the
+ *		statistics is likewise taken out of the optimization.
+ */
+
+void reportTotals()
+{
+    struct rusage usage;
+    double seconds;
+
+
+    if (reported > 1)
+	write("total", totals);
+
+    cerr << "  " << left << setw(14) << "phase" << right;
+    cerr << setw(10) << "ms" << endl;
+
+    for (unsigned i = 0; i < NUM_PHASES; i ++) {
+	seconds = totals.phases[i];
+
+	if (i == PARSING)
+	    seconds -= totals.phases[LEXING];
+	else if (i == OPTIMIZATION)
+	    seconds -= totals.overhead;
+
+	cerr << "  " << left << setw(14) << phases[i] << right;
+	cerr << fixed << setprecision(3) << setw(10) << seconds * 1000;
+	cerr << endl;
+    }
+
+    getrusage(RUSAGE_SELF, &usage);
+    cerr << "  peak RSS " << usage.ru_maxrss << " KB" << endl;
+}
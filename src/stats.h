@@ -0,0 +1,75 @@
+/*
+ * File:	stats.h
+ *
+ * Description:	This file contains the class definitions and public
+ *		function declarations for the statistics gathered about
+ *		optimizing each function.
+ *
+ *		For each pass, we record how many times it was run, how
+ *		many of those runs changed the function, how long it took,
+ *		how many statements it removed and rewrote, and how many
+ *		block visits the dataflow solver and how many rebuilds of
+ *		the flowgraph it needed.  The number of statements removed
+ *		is negative if the pass added statements.  For the function
+ *		as a whole, we record the number of rounds of optimization
+ *		and its size before and after, and the solver visits and
+ *		rebuilds include those needed by the code generator.
+ *
+ *		The time spent in each phase of the compiler is also
+ *		recorded.  Lexing and parsing are recorded only for the
+ *		whole unit, and the remaining phases for each function.
+ *		When functions are compiled concurrently, the times of the
+ *		later phases are therefore summed over all the threads.
+ *		The overhead of gathering the statistics for each pass is
+ *		recorded so that it can be taken out of the optimization.
+ */
+
+# ifndef STATS_H
+# define STATS_H
+# include <chrono>
+# include <string>
+# include <vector>
+
+enum Phase {
+    LEXING, PARSING, TRANSLATION, OPTIMIZATION, GENERATION, NUM_PHASES
+};
+
+struct PassStats {
+    std::string name;
+    unsigned runs, changes, visits, rebuilds;
+    int removed, rewritten;
+    double seconds;
+
+    PassStats(const std::string &name);
+};
+
+struct Stats {
+    unsigned rounds, visits, rebuilds;
+    unsigned before, after;
+    double phases[NUM_PHASES], overhead;
+    std::vector<PassStats> passes;
+
+    Stats();
+    PassStats &pass(const std::string &name);
+    void add(const Stats &stats);
+};
+
+class Timer {
+    double *_seconds;
+    std::chrono::steady_clock::time_point _start;
+
+public:
+    Timer(double &seconds);
+    ~Timer();
+    void stop();
+};
+
+double &phaseTime(Phase phase);
+
+bool runPass(struct Function &function, const std::string &name,
+	bool (*pass)(struct Function &));
+
+void reportStats(const std::string &name, const Stats &stats);
+void reportTotals();
+
+# endif /* STATS_H */
@@ -0,0 +1,163 @@
+/*
+ * File:	tailcall.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for eliminating tail calls.
+ *
+ *		A call is a tail call if the statement following it
+ *		returns its result.  If the function calls itself, the
+ *		arguments are assigned to the parameters and control jumps
+ *		back to the start of the body, so the recursion becomes a
+ *		loop.  The arguments are first copied into temporaries,
+ *		since each may refer to any of the parameters.
+ *
+ *		Any other tail call is marked as such and the return is
+ *		removed, so that the code generator can reuse our frame
+ *		for the callee and jump to it, leaving the callee to return
+ *		directly to our caller.  The callee must not be given the
+ *		address of one of our local arrays, since our frame is
+ *		gone by the time it runs, and if it returns a character,
+ *		then so must we, since only the caller of a function that
+ *		returns a character truncates the value.
+ */
+
+# include <vector>
+# include "flowgraph.h"
+# include "translator.h"
+# include "tokens.h"
+# include "tailcall.h"
+
+using namespace std;
+
+
+/*
+ * Function:	tailCall (private)
+ *
+ * Description:	Return the call at the end of the given block if it is a
+ *		tail call, or null otherwise.
+ */
+
+static Call *tailCall(Block *block)
+{
+    Call *call;
+    Return *ret;
+
+
+    if (block->begin() == block->end())
+	return nullptr;
+
+    auto last = prev(block->end());
+    ret = dynamic_cast<Return *>(*last);
+
+    if (ret == nullptr || last == block->begin())
+	return nullptr;
+
+    call = dynamic_cast<Call *>(*prev(last));
+
+    if (call == nullptr || call->_result == nullptr)
+	return nullptr;
+
+    return call->_result == ret->_expr ? call : nullptr;
+}
+
+
+/*
+ * Function:	reenter (private)
+ *
+ * Description:	Replace the given call of the function by itself, which
+ *		ends the given block, with assignments to the parameters
+ *		and a jump to the given start of the body, and return
+ *		whether it was replaced.  An array parameter is just the
+ *		address of the array, and must be passed unchanged.
+ */
+
+static bool reenter(Function &function, Block *block, Call *call, Label *start)
+{
+    Symbol *temp;
+    vector<Copy *> copies;
+    Statements::iterator pos(call);
+    const Symbols &symbols = function.locals->symbols();
+
+
+    for (unsigned i = 0; i < call->_arguments.size(); i ++)
+	if (symbols[i]->type().isPointer() && call->_arguments[i] != symbols[i])
+	    return false;
+
+    for (unsigned i = 0; i < call->_arguments.size(); i ++)
+	if (call->_arguments[i] != symbols[i]) {
+	    temp = makeTemp();
+	    insertStatement(function, block, pos,
+		new Copy(temp, call->_arguments[i]));
+	    copies.push_back(new Copy(symbols[i], temp));
+	}
+
+    for (auto copy : copies)
+	insertStatement(function, block, pos, copy);
+
+    eraseStatement(function, block, next(pos));
+    replaceStatement(function, block, pos, new Jump(start));
+    return true;
+}
+
+
+/*
+ * Function:	mayJump (private)
+ *
+ * Description:	Return whether the given tail call in the given function
+ *		may be made by jumping to the callee.
+ */
+
+static bool mayJump(Function &function, Call *call)
+{
+    Symbol *callee = call->_function;
+
+
+    if (callee->type().specifier() == CHAR)
+	if (function.symbol->type().specifier() != CHAR)
+	    return false;
+
+    for (auto arg : call->_arguments)
+	if (arg->kind() == LOCAL && arg->type().isArray())
+	    return false;
+
+    return true;
+}
+
+
+/*
+ * Function:	eliminateTailCalls
+ *
+ * Description:	Turn the tail calls of the given function to itself into
+ *		loops, mark its other tail calls, and return whether any
+ *		were found.
+ */
+
+bool eliminateTailCalls(Function &function)
+{
+    Call *call;
+    Label *start;
+    bool changed;
+
+
+    changed = false;
+    start = (*function.entry->next()->first())->asLabel();
+
+    for (auto block : getBlocks(function)) {
+	if ((call = tailCall(block)) == nullptr)
+	    continue;
+
+	if (call->_function == function.symbol) {
+	    if (call->_arguments.size() == function.symbol->
+		    type().parameters()->size())
+		changed = reenter(function, block, call, start) || changed;
+
+	} else if (mayJump(function, call)) {
+	    call->_result = nullptr;
+	    call->_tail = true;
+	    eraseStatement(function, block, prev(block->end()));
+	    changed = true;
+	}
+    }
+
+    return changed;
+}
@@ -0,0 +1,14 @@
+/*
+ * File:	tailcall.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		eliminating tail calls.
+ */
+
+# ifndef TAILCALL_H
+# define TAILCALL_H
+# include "Function.h"
+
+bool eliminateTailCalls(Function &function);
+
+# endif /* TAILCALL_H */
@@ -8,6 +8,7 @@
 
 # include <cassert>
 # include <unordered_map>
+# include "Arena.h"
 # include "translator.h"
 # include "literal.h"
 
@@ -15,8 +16,8 @@
 
 using namespace std;
 
-static unsigned numtemps;
-static Symbol *zero, *one;
+static thread_local unsigned numtemps;
+static thread_local Symbol *zero, *one;
 static void generate(Statements &stmts, Node *node);
 
 static unordered_map<int,int> inverses = {
@@ -24,6 +25,49 @@ static unordered_map<int,int> inverses = {
 };
 
 
+/*
+ * Function:	makeTemp
+ *
+ * Description:	Create a new temporary.  Temporaries belong to the function
+ *		being translated or optimized, so they are allocated from
+ *		its arena.
+ */
+
+Symbol *makeTemp()
+{
+    string name = "t" + to_string(numtemps ++);
+    return new (*Arena::current()) Symbol(name, Type(INT), TEMP);
+}
+
+
+/*
+ * Function:	countTemps
+ *
+ * Description:	Return the number of temporaries created so far for the
+ *		function being translated.
+ */
+
+unsigned countTemps()
+{
+    return numtemps;
+}
+
+
+/*
+ * Function:	resumeTemps
+ *
+ * Description:	Continue numbering temporaries from the given count, so
+ *		that a function translated earlier, perhaps on another
+ *		thread, may be optimized without reusing the names of its
+ *		temporaries.
+ */
+
+void resumeTemps(unsigned count)
+{
+    numtemps = count;
+}
+
+
 /*
  * Function:	newTemp (private)
  *
@@ -32,8 +76,7 @@ static unordered_map<int,int> inverses = {
 
 static Symbol *newTemp(Node *node)
 {
-    string name = "t" + to_string(numtemps ++);
-    node->_symbol = new Symbol(name, Type(INT), TEMP);
+    node->_symbol = makeTemp();
     return node->_symbol;
 }
 
@@ -69,7 +112,7 @@ static void test(Statements &stmts, Node *node, Label *target, bool ifTrue)
 	left = node->_kids[0]->_symbol;
 	right = node->_kids[1]->_symbol;
 
-	token = (ifTrue ? node->_token : inverses[node->_token]);
+	token = (ifTrue ? node->_token : inverses.at(node->_token));
 	emit(new Branch(token, left, right, target));
 	break;
 
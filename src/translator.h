@@ -1,14 +1,18 @@
 /*
  * File:	translator.h
  *
- * Description:	This file contains the public function declaration for
+ * Description:	This file contains the public function declarations for
  *		translating an AST into three-address statements.
  */
 
 # ifndef TRANSLATOR_H
+# define TRANSLATOR_H
 # include "Node.h"
 # include "Statement.h"
 
 Statements translate(Node *node);
+Symbol *makeTemp();
+unsigned countTemps();
+void resumeTemps(unsigned count);
 
 # endif /* TRANSLATOR_H */